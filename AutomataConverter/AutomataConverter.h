@@ -1,11 +1,12 @@
 ﻿#pragma once
+
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
 #include <string>
-#include <vector>
-#include <fstream>
-#include <sstream>
-#include <unordered_map>
-#include <unordered_set>
-#include <set>
-#include <map>
-#include <queue>
\ No newline at end of file
+#include <utility>
+
+#include "AutomataCore.h"
+#include "Batch.h"
+#include "Parallel.h"
+#include "PipelineStats.h"
@@ -0,0 +1,121 @@
+﻿#include "Arena.h"
+
+#include <algorithm>
+
+using namespace std;
+
+// Заголовок крупного блока: двусвязный список живых блоков
+struct ArenaLargeBlock {
+    ArenaLargeBlock* prev;
+    ArenaLargeBlock* next;
+    size_t bytes;
+};
+
+// Данные крупного блока выровнены как max_align_t
+const size_t LARGE_HEADER_BYTES = (sizeof(ArenaLargeBlock) + alignof(max_align_t) - 1) / alignof(max_align_t) * alignof(max_align_t);
+
+static thread_local pmr::memory_resource* currentArena = nullptr;
+
+void* Arena::SystemMemory::do_allocate(size_t bytes, size_t alignment) {
+    void* pointer = pmr::new_delete_resource()->allocate(bytes, alignment);
+    current += bytes;
+    peak = max(peak, current);
+    return pointer;
+}
+
+void Arena::SystemMemory::do_deallocate(void* pointer, size_t bytes, size_t alignment) {
+    pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+    current -= bytes;
+}
+
+bool Arena::SystemMemory::do_is_equal(const pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+Arena::Arena(size_t initialBytes)
+    : initialBytes(max<size_t>(initialBytes, 1)),
+    initialBuffer(system.allocate(this->initialBytes, alignof(max_align_t))),
+    small(initialBuffer, this->initialBytes, &system)
+{
+}
+
+Arena::~Arena() {
+    Release();
+    system.deallocate(initialBuffer, initialBytes, alignof(max_align_t));
+}
+
+void Arena::Release() {
+    lock_guard<mutex> lock(arenaMutex);
+    small.release();
+    while (largeBlocks != nullptr) {
+        ArenaLargeBlock* block = largeBlocks;
+        largeBlocks = block->next;
+        system.deallocate(block, block->bytes, alignof(max_align_t));
+    }
+    system.peak = system.current;
+    requestedBytes = 0;
+    allocations = 0;
+}
+
+ArenaStats Arena::Stats() const {
+    lock_guard<mutex> lock(arenaMutex);
+    ArenaStats stats;
+    stats.peakBytes = system.peak;
+    stats.requestedBytes = requestedBytes;
+    stats.allocations = allocations;
+    return stats;
+}
+
+void* Arena::do_allocate(size_t bytes, size_t alignment) {
+    lock_guard<mutex> lock(arenaMutex);
+    requestedBytes += bytes;
+    allocations++;
+    if (bytes < ARENA_LARGE_BLOCK_BYTES || alignment > alignof(max_align_t)) {
+        return small.allocate(bytes, alignment);
+    }
+    size_t total = LARGE_HEADER_BYTES + bytes;
+    ArenaLargeBlock* block = static_cast<ArenaLargeBlock*>(system.allocate(total, alignof(max_align_t)));
+    block->prev = nullptr;
+    block->next = largeBlocks;
+    block->bytes = total;
+    if (largeBlocks != nullptr) {
+        largeBlocks->prev = block;
+    }
+    largeBlocks = block;
+    return reinterpret_cast<char*>(block) + LARGE_HEADER_BYTES;
+}
+
+// Мелкие блоки не освобождаются до Release, крупные сразу возвращаются системе
+void Arena::do_deallocate(void* pointer, size_t bytes, size_t alignment) {
+    if (bytes < ARENA_LARGE_BLOCK_BYTES || alignment > alignof(max_align_t)) {
+        return;
+    }
+    lock_guard<mutex> lock(arenaMutex);
+    ArenaLargeBlock* block = reinterpret_cast<ArenaLargeBlock*>(static_cast<char*>(pointer) - LARGE_HEADER_BYTES);
+    if (block->prev != nullptr) {
+        block->prev->next = block->next;
+    }
+    else {
+        largeBlocks = block->next;
+    }
+    if (block->next != nullptr) {
+        block->next->prev = block->prev;
+    }
+    system.deallocate(block, LARGE_HEADER_BYTES + bytes, alignof(max_align_t));
+}
+
+bool Arena::do_is_equal(const pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+pmr::memory_resource* CurrentArena() {
+    return currentArena != nullptr ? currentArena : pmr::get_default_resource();
+}
+
+ArenaScope::ArenaScope(Arena& arena) : previous(currentArena) {
+    currentArena = &arena;
+}
+
+ArenaScope::~ArenaScope() {
+    currentArena = previous;
+}
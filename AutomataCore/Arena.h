@@ -0,0 +1,79 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <mutex>
+
+// Арена одного запуска: таблицы автоматов, таблицы классов минимизации и карты преобразований
+// берут память из арены текущего потока и освобождаются разом (Release или деструктор).
+// Мелкие блоки выделяются подряд из общих кусков (monotonic_buffer_resource),
+// крупные - отдельно и возвращаются системе сразу при освобождении,
+// чтобы рабочие массивы соседних стадий конвейера не копились до конца запуска
+const size_t ARENA_INITIAL_BYTES = 64 * 1024;
+const size_t ARENA_LARGE_BLOCK_BYTES = 64 * 1024;
+
+struct ArenaLargeBlock;
+
+struct ArenaStats {
+    // Наибольший объём памяти, полученной ареной от системы (high-water mark)
+    size_t peakBytes = 0;
+    // Запрошено с последнего Release
+    size_t requestedBytes = 0;
+    size_t allocations = 0;
+};
+
+// Выделение и освобождение потокобезопасны: в таблицы, созданные потоком с ареной,
+// пишут и рабочие потоки RunParallel
+class Arena : public std::pmr::memory_resource {
+public:
+    explicit Arena(size_t initialBytes = ARENA_INITIAL_BYTES);
+    ~Arena();
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // Освобождает всю выделенную память, начальный кусок остаётся для следующего запуска
+    void Release();
+    ArenaStats Stats() const;
+
+private:
+    // Учёт памяти, полученной от системы
+    class SystemMemory : public std::pmr::memory_resource {
+    public:
+        size_t current = 0;
+        size_t peak = 0;
+
+    private:
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+    };
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    mutable std::mutex arenaMutex;
+    SystemMemory system;
+    size_t initialBytes;
+    void* initialBuffer;
+    std::pmr::monotonic_buffer_resource small;
+    // живые крупные блоки, освобождаются в Release
+    ArenaLargeBlock* largeBlocks = nullptr;
+    size_t requestedBytes = 0;
+    size_t allocations = 0;
+};
+
+// Ресурс для новых таблиц в текущем потоке: арена ArenaScope или ресурс по умолчанию
+std::pmr::memory_resource* CurrentArena();
+
+// Делает арену текущей для потока до конца области видимости
+class ArenaScope {
+public:
+    explicit ArenaScope(Arena& arena);
+    ~ArenaScope();
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+private:
+    std::pmr::memory_resource* previous;
+};
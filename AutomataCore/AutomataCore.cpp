@@ -0,0 +1,446 @@
+﻿#include "AutomataCore.h"
+#include "OutputBuffer.h"
+
+#include <algorithm>
+#include <charconv>
+#include <iostream>
+
+using namespace std;
+
+// FNV-1a: не зависит от реализации std::hash, поэтому индекс можно сохранять в бинарный файл
+static uint64_t HashName(string_view name) {
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (char ch : name) {
+        hash = (hash ^ static_cast<unsigned char>(ch)) * 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+static size_t FindSlot(const SymbolTable& table, string_view name) {
+    size_t mask = table.slots.size() - 1;
+    size_t slot = static_cast<size_t>(HashName(name)) & mask;
+    while (table.slots[slot] != 0 && SymbolName(table, table.slots[slot] - 1) != name) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+static void RehashSymbols(SymbolTable& table, size_t capacity) {
+    table.slots.assign(capacity, 0);
+    uint32_t count = SymbolCount(table);
+    // при повторе имени ссылки ведут на первое вхождение
+    for (uint32_t id = 0; id < count; id++) {
+        size_t slot = FindSlot(table, SymbolName(table, id));
+        if (table.slots[slot] == 0) {
+            table.slots[slot] = id + 1;
+        }
+    }
+}
+
+uint32_t InternSymbol(SymbolTable& table, string_view name) {
+    if (!table.slots.empty()) {
+        uint32_t found = table.slots[FindSlot(table, name)];
+        if (found != 0) {
+            return found - 1;
+        }
+    }
+    return AddSymbol(table, name);
+}
+
+uint32_t AddSymbol(SymbolTable& table, string_view name) {
+    uint32_t id = SymbolCount(table);
+    if ((size_t(id) + 1) * 2 > table.slots.size()) {
+        RehashSymbols(table, max<size_t>(16, table.slots.size() * 2));
+    }
+    size_t slot = FindSlot(table, name);
+    table.pool.append(name);
+    table.offsets.push_back(table.pool.size());
+    if (table.slots[slot] == 0) {
+        table.slots[slot] = id + 1;
+    }
+    return id;
+}
+
+uint32_t FindSymbol(const SymbolTable& table, string_view name) {
+    if (table.slots.empty()) {
+        return NO_SYMBOL;
+    }
+    uint32_t found = table.slots[FindSlot(table, name)];
+    return found == 0 ? NO_SYMBOL : found - 1;
+}
+
+string_view SymbolName(const SymbolTable& table, uint32_t id) {
+    if (id == NO_SYMBOL) {
+        return {};
+    }
+    return string_view(table.pool.data() + table.offsets[id], table.offsets[id + 1] - table.offsets[id]);
+}
+
+uint32_t SymbolCount(const SymbolTable& table) {
+    return static_cast<uint32_t>(table.offsets.size() - 1);
+}
+
+void ReserveSymbols(SymbolTable& table, size_t count, size_t totalLength) {
+    table.pool.reserve(totalLength);
+    table.offsets.reserve(count + 1);
+    size_t capacity = 16;
+    while (capacity < count * 2) {
+        capacity *= 2;
+    }
+    if (capacity > table.slots.size()) {
+        RehashSymbols(table, capacity);
+    }
+}
+
+void GenerateSymbols(SymbolTable& table, string_view prefix, uint32_t count) {
+    ReserveSymbols(table, SymbolCount(table) + size_t(count), table.pool.size() + size_t(count) * (prefix.size() + 10));
+    char name[64];
+    prefix.copy(name, prefix.size());
+    for (uint32_t id = 0; id < count; id++) {
+        char* nameEnd = to_chars(name + prefix.size(), name + sizeof(name), id).ptr;
+        AddSymbol(table, string_view(name, nameEnd - name));
+    }
+}
+
+size_t Utf8Length(string_view text, size_t pos) {
+    unsigned char lead = static_cast<unsigned char>(text[pos]);
+    size_t length = lead < 0x80 ? 1 : lead < 0xC0 ? 0 : lead < 0xE0 ? 2 : lead < 0xF0 ? 3 : lead < 0xF8 ? 4 : 0;
+    if (length == 0 || pos + length > text.size()) {
+        return 0;
+    }
+    for (size_t i = 1; i < length; i++) {
+        if ((static_cast<unsigned char>(text[pos + i]) & 0xC0) != 0x80) {
+            return 0;
+        }
+    }
+    return length;
+}
+
+void WriteMooreCsv(const MooreAutomata& automata, OutputBuffer& file) {
+    // outputs
+    for (uint32_t state = 0; state < automata.numStates; state++) {
+        string_view output = SymbolName(automata.outputSymbols, automata.outputs[state]);
+        file.Append(';');
+        if (output != BLANK_OUTPUT_CH) {
+            file.Append(output);
+        }
+    }
+    file.Append('\n');
+    for (uint32_t state = 0; state < automata.numStates; state++) {
+        file.Append(';');
+        file.Append(SymbolName(automata.states, state));
+    }
+    file.Append('\n');
+    // inputs and transitions
+    for (uint32_t input = 0; input < automata.numInputs; input++) {
+        file.Append(SymbolName(automata.inputs, input));
+        file.Append(';');
+        for (uint32_t state = 0; state < automata.numStates; state++) {
+            file.Append(SymbolName(automata.states, automata.next[size_t(state) * automata.numInputs + input]));
+            if (state != automata.numStates - 1) {
+                file.Append(';');
+            }
+        }
+        file.Append('\n');
+    }
+}
+
+void WriteMealyCsv(const MealyAutomata& automata, OutputBuffer& file) {
+    for (uint32_t state = 0; state < automata.numStates; state++) {
+        file.Append(';');
+        file.Append(SymbolName(automata.states, state));
+    }
+    file.Append('\n');
+    for (uint32_t input = 0; input < automata.numInputs; input++) {
+        file.Append(SymbolName(automata.inputs, input));
+        file.Append(';');
+        for (uint32_t state = 0; state < automata.numStates; state++) {
+            size_t cell = size_t(state) * automata.numInputs + input;
+            file.Append(SymbolName(automata.states, automata.next[cell]));
+            file.Append('/');
+            file.Append(SymbolName(automata.outputSymbols, automata.outputs[cell]));
+            if (state != automata.numStates - 1) {
+                file.Append(';');
+            }
+        }
+        file.Append('\n');
+    }
+}
+
+template <typename Automata, typename Write>
+static bool ExportToCSV(const Automata& automata, const string& filename, Write write) {
+    OutputBuffer file(filename);
+    if (!file.IsOpen()) {
+        cerr << "Failed to open file: " << filename << endl;
+        return false;
+    }
+    write(automata, file);
+    if (!file.Close()) {
+        cerr << "Failed to write file: " << filename << endl;
+        return false;
+    }
+    return true;
+}
+
+bool ExportMooreToCSV(const MooreAutomata& automata, const string& filename) {
+    return ExportToCSV(automata, filename, WriteMooreCsv);
+}
+
+bool ExportMealyToCSV(const MealyAutomata& automata, const string& filename) {
+    return ExportToCSV(automata, filename, WriteMealyCsv);
+}
+
+string MooreToCsv(const MooreAutomata& automata) {
+    string text;
+    OutputBuffer buffer(text);
+    WriteMooreCsv(automata, buffer);
+    buffer.Close();
+    return text;
+}
+
+string MealyToCsv(const MealyAutomata& automata) {
+    string text;
+    OutputBuffer buffer(text);
+    WriteMealyCsv(automata, buffer);
+    buffer.Close();
+    return text;
+}
+
+void PrintMooreAutomata(const MooreAutomata& automata) {
+    cout << "Outputs:" << endl;
+    for (uint32_t state = 0; state < automata.numStates; state++) {
+        cout << SymbolName(automata.states, state) << " -> " << SymbolName(automata.outputSymbols, automata.outputs[state]) << endl;
+    }
+
+    cout << "\nStates:" << endl;
+    for (uint32_t state = 0; state < automata.numStates; state++) {
+        cout << SymbolName(automata.states, state) << endl;
+    }
+
+    cout << "\nInputs:" << endl;
+    for (uint32_t input = 0; input < automata.numInputs; input++) {
+        cout << SymbolName(automata.inputs, input) << endl;
+    }
+
+    cout << "\nTransitions:" << endl;
+    for (uint32_t input = 0; input < automata.numInputs; input++) {
+        cout << "Input: " << SymbolName(automata.inputs, input) << "\n";
+        for (uint32_t state = 0; state < automata.numStates; state++) {
+            uint32_t nextState = automata.next[size_t(state) * automata.numInputs + input];
+            cout << "State: " << SymbolName(automata.states, state) << " -> " << SymbolName(automata.states, nextState) << "\n";
+        }
+    }
+}
+
+void PrintMealyAutomata(const MealyAutomata& mealyAutomata) {
+    cout << "States:" << endl;
+    for (uint32_t state = 0; state < mealyAutomata.numStates; state++) {
+        cout << SymbolName(mealyAutomata.states, state) << endl;
+    }
+
+    cout << "\nInputs:" << endl;
+    for (uint32_t input = 0; input < mealyAutomata.numInputs; input++) {
+        cout << SymbolName(mealyAutomata.inputs, input) << endl;
+    }
+
+    cout << "\nTransitions:" << endl;
+    for (uint32_t input = 0; input < mealyAutomata.numInputs; input++) {
+        cout << "Input: " << SymbolName(mealyAutomata.inputs, input) << endl;
+        for (uint32_t state = 0; state < mealyAutomata.numStates; state++) {
+            size_t cell = size_t(state) * mealyAutomata.numInputs + input;
+            cout << "State: " << SymbolName(mealyAutomata.states, state) << " -> " << SymbolName(mealyAutomata.states, mealyAutomata.next[cell])
+                << "/" << SymbolName(mealyAutomata.outputSymbols, mealyAutomata.outputs[cell]) << endl;
+        }
+    }
+}
+
+// Обход в ширину от начального состояния (первый столбец), O(n·k).
+// Возвращает достижимые состояния в порядке посещения
+static pmr::vector<uint32_t> VisitReachableStates(const pmr::vector<uint32_t>& next, uint32_t numStates, uint32_t numInputs) {
+    pmr::vector<bool> reachable(numStates, false, CurrentArena());
+    // очередь - сам массив посещённых состояний, каждое попадает в него один раз
+    pmr::vector<uint32_t> visited(CurrentArena());
+    visited.reserve(numStates);
+    visited.push_back(0);
+    reachable[0] = true;
+    for (size_t head = 0; head < visited.size(); head++) {
+        const uint32_t* row = next.data() + size_t(visited[head]) * numInputs;
+        for (uint32_t input = 0; input < numInputs; input++) {
+            uint32_t nextState = row[input];
+            if (nextState != NO_STATE && !reachable[nextState]) {
+                reachable[nextState] = true;
+                visited.push_back(nextState);
+            }
+        }
+    }
+    return visited;
+}
+
+// Новый номер для каждого состояния или NO_STATE для недостижимых
+static vector<uint32_t> NumberReachableStates(const pmr::vector<uint32_t>& next, uint32_t numStates, uint32_t numInputs) {
+    pmr::vector<uint32_t> visited = VisitReachableStates(next, numStates, numInputs);
+    // Сохраняем исходный порядок столбцов
+    vector<uint32_t> newIndex(numStates, NO_STATE);
+    for (uint32_t state : visited) {
+        newIndex[state] = 0;
+    }
+    uint32_t count = 0;
+    for (uint32_t state = 0; state < numStates; state++) {
+        if (newIndex[state] != NO_STATE) {
+            newIndex[state] = count++;
+        }
+    }
+    return newIndex;
+}
+
+static uint32_t Remap(const vector<uint32_t>& newIndex, uint32_t state) {
+    return state == NO_STATE ? NO_STATE : newIndex[state];
+}
+
+// Сдвигает оставшиеся имена к началу буфера: новый номер не больше старого,
+// поэтому перенос идёт без второй копии таблицы
+static void CompactSymbols(SymbolTable& table, const vector<uint32_t>& newIndex) {
+    uint32_t count = SymbolCount(table);
+    size_t poolEnd = 0;
+    uint32_t kept = 0;
+    for (uint32_t id = 0; id < count; id++) {
+        if (newIndex[id] == NO_STATE) {
+            continue;
+        }
+        size_t begin = table.offsets[id];
+        size_t length = table.offsets[id + 1] - begin;
+        copy(table.pool.begin() + begin, table.pool.begin() + begin + length, table.pool.begin() + poolEnd);
+        poolEnd += length;
+        table.offsets[++kept] = poolEnd;
+    }
+    table.pool.resize(poolEnd);
+    table.offsets.resize(size_t(kept) + 1);
+    RehashSymbols(table, table.slots.size());
+}
+
+// Строки переходов сдвигаются на место удалённых состояний, копия автомата не создаётся
+template <typename Automata>
+static void CompactStates(Automata& automata, const vector<uint32_t>& newIndex, size_t outputsPerState) {
+    size_t inputs = automata.numInputs;
+    uint32_t kept = 0;
+    for (uint32_t state = 0; state < automata.numStates; state++) {
+        if (newIndex[state] == NO_STATE) {
+            continue;
+        }
+        for (size_t input = 0; input < inputs; input++) {
+            automata.next[kept * inputs + input] = Remap(newIndex, automata.next[state * inputs + input]);
+        }
+        for (size_t i = 0; i < outputsPerState; i++) {
+            automata.outputs[kept * outputsPerState + i] = automata.outputs[state * outputsPerState + i];
+        }
+        kept++;
+    }
+    automata.next.resize(kept * inputs);
+    automata.outputs.resize(kept * outputsPerState);
+    CompactSymbols(automata.states, newIndex);
+    automata.numStates = kept;
+}
+
+vector<uint32_t> RemoveUnreachableStatesMoore(MooreAutomata& automata) {
+    if (automata.numStates == 0) {
+        return {};
+    }
+    vector<uint32_t> newIndex = NumberReachableStates(automata.next, automata.numStates, automata.numInputs);
+    CompactStates(automata, newIndex, 1);
+    return newIndex;
+}
+
+vector<uint32_t> RemoveUnreachableStatesMealy(MealyAutomata& automata)
+{
+    if (automata.numStates == 0) {
+        return {};
+    }
+    vector<uint32_t> newIndex = NumberReachableStates(automata.next, automata.numStates, automata.numInputs);
+    CompactStates(automata, newIndex, automata.numInputs);
+    return newIndex;
+}
+
+// Горячие состояния - по числу посещений на образце, при равенстве и для непосещённых - порядок обхода в ширину,
+// недостижимые - в конце в исходном порядке
+static vector<uint32_t> OrderStates(const pmr::vector<uint32_t>& next, uint32_t numStates, uint32_t numInputs,
+    StateOrder order, const vector<uint32_t>& trace)
+{
+    vector<uint32_t> newIndex(numStates);
+    if (order == StateOrder::Original || numStates == 0) {
+        for (uint32_t state = 0; state < numStates; state++) {
+            newIndex[state] = state;
+        }
+        return newIndex;
+    }
+    pmr::vector<uint32_t> visited = VisitReachableStates(next, numStates, numInputs);
+    if (order == StateOrder::Frequency) {
+        pmr::vector<uint64_t> visits(numStates, 0, CurrentArena());
+        uint32_t state = 0;
+        for (uint32_t symbol : trace) {
+            uint32_t nextState = symbol < numInputs ? next[size_t(state) * numInputs + symbol] : NO_STATE;
+            state = nextState == NO_STATE ? 0 : nextState;
+            visits[state]++;
+        }
+        // начальное состояние остаётся первым
+        visits[0] = UINT64_MAX;
+        stable_sort(visited.begin(), visited.end(), [&](uint32_t a, uint32_t b) {
+            return visits[a] > visits[b];
+        });
+    }
+    fill(newIndex.begin(), newIndex.end(), NO_STATE);
+    uint32_t count = 0;
+    for (uint32_t state : visited) {
+        newIndex[state] = count++;
+    }
+    for (uint32_t state = 0; state < numStates; state++) {
+        if (newIndex[state] == NO_STATE) {
+            newIndex[state] = count++;
+        }
+    }
+    return newIndex;
+}
+
+vector<uint32_t> StateOrderMoore(const MooreAutomata& automata, StateOrder order, const vector<uint32_t>& trace) {
+    return OrderStates(automata.next, automata.numStates, automata.numInputs, order, trace);
+}
+
+vector<uint32_t> StateOrderMealy(const MealyAutomata& automata, StateOrder order, const vector<uint32_t>& trace) {
+    return OrderStates(automata.next, automata.numStates, automata.numInputs, order, trace);
+}
+
+// Строки переставляются в новые таблицы из той же арены, имена состояний - вместе со строками
+template <typename Automata>
+static void PermuteStates(Automata& automata, const vector<uint32_t>& newIndex, size_t outputsPerState) {
+    size_t inputs = automata.numInputs;
+    pmr::vector<uint32_t> next(automata.next.size(), NO_STATE, automata.next.get_allocator());
+    pmr::vector<uint32_t> outputs(automata.outputs.size(), NO_SYMBOL, automata.outputs.get_allocator());
+    vector<uint32_t> oldIndex(automata.numStates);
+    for (uint32_t state = 0; state < automata.numStates; state++) {
+        size_t target = newIndex[state];
+        oldIndex[target] = state;
+        for (size_t input = 0; input < inputs; input++) {
+            next[target * inputs + input] = Remap(newIndex, automata.next[state * inputs + input]);
+        }
+        for (size_t i = 0; i < outputsPerState; i++) {
+            outputs[target * outputsPerState + i] = automata.outputs[state * outputsPerState + i];
+        }
+    }
+    automata.next.swap(next);
+    automata.outputs.swap(outputs);
+    if (SymbolCount(automata.states) == automata.numStates) {
+        SymbolTable states;
+        ReserveSymbols(states, automata.numStates, automata.states.pool.size());
+        for (uint32_t state : oldIndex) {
+            AddSymbol(states, SymbolName(automata.states, state));
+        }
+        automata.states = move(states);
+    }
+}
+
+void RenumberStatesMoore(MooreAutomata& automata, const vector<uint32_t>& newIndex) {
+    PermuteStates(automata, newIndex, 1);
+}
+
+void RenumberStatesMealy(MealyAutomata& automata, const vector<uint32_t>& newIndex) {
+    PermuteStates(automata, newIndex, automata.numInputs);
+}
@@ -0,0 +1,182 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Arena.h"
+
+class OutputBuffer;
+
+// Отсутствующий переход (пустая ячейка в CSV)
+const uint32_t NO_STATE = UINT32_MAX;
+// Отсутствующий выходной символ
+const uint32_t NO_SYMBOL = UINT32_MAX;
+
+const std::string BLANK_OUTPUT_CH = "_";
+
+// Таблица имён: используется только при чтении и записи CSV,
+// алгоритмы работают с числовыми идентификаторами.
+// Имена хранятся подряд в одном буфере, поиск - открытая адресация,
+// поэтому добавление имени из string_view не выделяет память на каждую ячейку.
+// Таблицы имён и переходов берут память из арены потока, в котором создан автомат (см. Arena.h)
+struct SymbolTable {
+    // i-е имя - pool[offsets[i], offsets[i + 1])
+    std::pmr::string pool{ CurrentArena() };
+    std::pmr::vector<size_t> offsets{ std::initializer_list<size_t>{ 0 }, CurrentArena() };
+    // номер имени + 1, 0 - свободная ячейка; размер - степень двойки
+    std::pmr::vector<uint32_t> slots{ CurrentArena() };
+};
+
+// Возвращает идентификатор имени, добавляя его при первой встрече
+uint32_t InternSymbol(SymbolTable& table, std::string_view name);
+// Добавляет имя без проверки на повтор (столбцы состояний, строки входов)
+uint32_t AddSymbol(SymbolTable& table, std::string_view name);
+// NO_SYMBOL, если имени нет в таблице
+uint32_t FindSymbol(const SymbolTable& table, std::string_view name);
+// Имя действительно до следующего добавления в таблицу
+std::string_view SymbolName(const SymbolTable& table, uint32_t id);
+uint32_t SymbolCount(const SymbolTable& table);
+void ReserveSymbols(SymbolTable& table, size_t count, size_t totalLength);
+// Добавляет имена prefix + 0, prefix + 1, ... (короткий префикс, например "X" или "q")
+void GenerateSymbols(SymbolTable& table, std::string_view prefix, uint32_t count);
+// Длина символа UTF-8, начинающегося с pos; 0 - неверная последовательность
+size_t Utf8Length(std::string_view text, size_t pos);
+
+struct MooreAutomata {
+    uint32_t numStates = 0;
+    uint32_t numInputs = 0;
+    // next[state * numInputs + input]
+    std::pmr::vector<uint32_t> next{ CurrentArena() };
+    // outputs[state]
+    std::pmr::vector<uint32_t> outputs{ CurrentArena() };
+    SymbolTable states;
+    SymbolTable inputs;
+    SymbolTable outputSymbols;
+};
+
+struct MealyAutomata {
+    uint32_t numStates = 0;
+    uint32_t numInputs = 0;
+    // next[state * numInputs + input]
+    std::pmr::vector<uint32_t> next{ CurrentArena() };
+    // outputs[state * numInputs + input]
+    std::pmr::vector<uint32_t> outputs{ CurrentArena() };
+    SymbolTable states;
+    SymbolTable inputs;
+    SymbolTable outputSymbols;
+};
+
+// threads > 1 - строки переходов разбираются параллельно, результат не зависит от числа потоков
+MooreAutomata ReadMoore(const std::string& inputFile, unsigned threads = 1);
+MealyAutomata ReadMealy(const std::string& inputFile, unsigned threads = 1);
+MooreAutomata ParseMooreCsv(std::string_view data, unsigned threads = 1);
+MealyAutomata ParseMealyCsv(std::string_view data, unsigned threads = 1);
+
+bool ExportMooreToCSV(const MooreAutomata& automata, const std::string& filename);
+bool ExportMealyToCSV(const MealyAutomata& automata, const std::string& filename);
+std::string MooreToCsv(const MooreAutomata& automata);
+std::string MealyToCsv(const MealyAutomata& automata);
+
+// Стадии конвейера изменяют автомат на месте: таблицы сжимаются без промежуточных копий.
+// Возвращают новый номер для каждого исходного состояния, NO_STATE - состояние удалено
+std::vector<uint32_t> RemoveUnreachableStatesMoore(MooreAutomata& automata);
+std::vector<uint32_t> RemoveUnreachableStatesMealy(MealyAutomata& automata);
+
+// Порядок номеров состояний для кэша: состояния, которые проходятся подряд, оказываются рядом в таблице.
+// Начальное состояние остаётся нулевым, недостижимые уходят в конец
+enum class StateOrder {
+    Original,
+    // обход в ширину от начального состояния
+    Bfs,
+    // по убыванию числа посещений на образце входа, непосещённые - в порядке обхода в ширину
+    Frequency
+};
+
+// Новый номер для каждого состояния; trace - номера входов образца для Frequency,
+// с неизвестного входа или пустого перехода образец продолжается с начального состояния
+std::vector<uint32_t> StateOrderMoore(const MooreAutomata& automata, StateOrder order, const std::vector<uint32_t>& trace = {});
+std::vector<uint32_t> StateOrderMealy(const MealyAutomata& automata, StateOrder order, const std::vector<uint32_t>& trace = {});
+// Переставляет строки таблиц и имена состояний; newIndex - перестановка всех состояний.
+// Перед минимизацией задаёт и порядок классов: они нумеруются по первому вхождению
+void RenumberStatesMoore(MooreAutomata& automata, const std::vector<uint32_t>& newIndex);
+void RenumberStatesMealy(MealyAutomata& automata, const std::vector<uint32_t>& newIndex);
+
+enum class MinimizationEngine {
+    // Разбиение Хопкрофта с обратными переходами, O(n·k·log n)
+    Hopcroft,
+    // Прежний алгоритм: пересчёт классов до стабилизации, для сверки результатов
+    Legacy,
+    // Пересчёт классов раундами, сигнатуры состояний хешируются и сравниваются на threads потоках
+    Parallel
+};
+
+// Номера классов не зависят ни от алгоритма, ни от числа потоков
+void MinimizeMoore(MooreAutomata& automata, MinimizationEngine engine = MinimizationEngine::Hopcroft, unsigned threads = 1);
+void MinimizeMealy(MealyAutomata& automata, MinimizationEngine engine = MinimizationEngine::Hopcroft, unsigned threads = 1);
+
+// Преобразования забирают таблицы исходного автомата, чтобы не копировать их
+MealyAutomata ConvertMooreToMealy(MooreAutomata&& moore);
+// Состояния Мура - копии состояний Мили по выходам входящих переходов, O(n·k + m)
+MooreAutomata AltConvertMealyToMoore(MealyAutomata&& mealy);
+
+// Бинарный формат: заголовок, таблицы имён и плоская таблица переходов uint32_t.
+// Загрузка отображает файл в память и копирует секции целиком
+const uint32_t BINARY_FORMAT_VERSION = 1;
+
+enum class AutomataFileKind {
+    Missing,
+    MooreCsv,
+    MealyCsv,
+    MooreBinary,
+    MealyBinary
+};
+
+AutomataFileKind DetectAutomataFile(const std::string& filename);
+AutomataFileKind DetectAutomataData(std::string_view data);
+bool IsBinaryFileName(const std::string& filename);
+
+MooreAutomata LoadMooreBinary(const std::string& filename);
+MealyAutomata LoadMealyBinary(const std::string& filename);
+bool SaveMooreBinary(const MooreAutomata& automata, const std::string& filename);
+bool SaveMealyBinary(const MealyAutomata& automata, const std::string& filename);
+std::string MooreToBinary(const MooreAutomata& automata);
+std::string MealyToBinary(const MealyAutomata& automata);
+
+// Читают CSV или бинарный файл по содержимому, пишут бинарный файл для имён *.bin.
+// false - файл не открылся или бинарный файл испорчен либо другого типа; automata тогда пуст
+bool LoadMoore(const std::string& filename, MooreAutomata& automata, unsigned threads = 1);
+bool LoadMealy(const std::string& filename, MealyAutomata& automata, unsigned threads = 1);
+bool SaveMoore(const MooreAutomata& automata, const std::string& filename);
+bool SaveMealy(const MealyAutomata& automata, const std::string& filename);
+
+// Режимы csv2bin / bin2csv: тип автомата определяется по входному файлу
+bool ConvertCsvToBinary(const std::string& inputFile, const std::string& outputFile, unsigned threads = 1);
+bool ConvertBinaryToCsv(const std::string& inputFile, const std::string& outputFile);
+
+// Работа с буферами в памяти - для встраивания без файлов и запуска процессов.
+// Формат входного буфера определяется по содержимому
+enum class AutomataFormat {
+    Csv,
+    Binary
+};
+
+// false - испорченный бинарный буфер или буфер другого типа, как у LoadMoore / LoadMealy
+bool LoadMooreFromBuffer(std::string_view data, MooreAutomata& automata, unsigned threads = 1);
+bool LoadMealyFromBuffer(std::string_view data, MealyAutomata& automata, unsigned threads = 1);
+std::string SaveMooreToBuffer(const MooreAutomata& automata, AutomataFormat format);
+std::string SaveMealyToBuffer(const MealyAutomata& automata, AutomataFormat format);
+// Перезаписывают target, сохраняя его ёмкость - для повторного использования буфера
+void SaveMooreToBuffer(const MooreAutomata& automata, AutomataFormat format, std::string& target);
+void SaveMealyToBuffer(const MealyAutomata& automata, AutomataFormat format, std::string& target);
+// Запись в открытый OutputBuffer (файл или строку)
+void WriteMooreCsv(const MooreAutomata& automata, OutputBuffer& buffer);
+void WriteMealyCsv(const MealyAutomata& automata, OutputBuffer& buffer);
+void WriteMooreBinary(const MooreAutomata& automata, OutputBuffer& buffer);
+void WriteMealyBinary(const MealyAutomata& automata, OutputBuffer& buffer);
+
+// Отладочный вывод в cout
+void PrintMooreAutomata(const MooreAutomata& automata);
+void PrintMealyAutomata(const MealyAutomata& automata);
@@ -0,0 +1,305 @@
+﻿#include "Batch.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+const string BATCH_MEALY = "mealy";
+const string BATCH_MOORE = "moore";
+const string BATCH_MEALY_TO_MOORE = "mealy-to-moore";
+const string BATCH_MOORE_TO_MEALY = "moore-to-mealy";
+const string BATCH_MEALY_TO_MOORE_MIN = "mealy-to-moore-min";
+const string BATCH_MOORE_TO_MEALY_MIN = "moore-to-mealy-min";
+const string BATCH_CSV_TO_BIN = "csv2bin";
+const string BATCH_BIN_TO_CSV = "bin2csv";
+
+struct BatchJob {
+    size_t id = 0;
+    size_t line = 0;
+    string mode;
+    string input;
+    string output;
+};
+
+// Рабочие буферы потока: между заданиями очищается только содержимое, память остаётся выделенной
+struct BatchWorkspace {
+    string input;
+    string output;
+};
+
+struct JobResult {
+    string error;
+    uint32_t states = 0;
+    double readMs = 0;
+    double processMs = 0;
+    double writeMs = 0;
+    ArenaStats arena;
+};
+
+static bool ReadWholeFile(const string& path, string& target) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    bool ok = fseek(file, 0, SEEK_END) == 0;
+    long size = ok ? ftell(file) : -1;
+    ok = size >= 0 && fseek(file, 0, SEEK_SET) == 0;
+    if (ok) {
+        target.resize(size_t(size));
+        ok = fread(target.data(), 1, target.size(), file) == target.size();
+    }
+    fclose(file);
+    return ok;
+}
+
+static bool WriteWholeFile(const string& path, const string& data) {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    bool ok = fwrite(data.data(), 1, data.size(), file) == data.size();
+    return fclose(file) == 0 && ok;
+}
+
+static AutomataFormat FormatFor(const string& filename) {
+    return IsBinaryFileName(filename) ? AutomataFormat::Binary : AutomataFormat::Csv;
+}
+
+static bool IsBatchMode(const string& mode) {
+    for (const string* known : { &BATCH_MEALY, &BATCH_MOORE, &BATCH_MEALY_TO_MOORE, &BATCH_MOORE_TO_MEALY,
+        &BATCH_MEALY_TO_MOORE_MIN, &BATCH_MOORE_TO_MEALY_MIN, &BATCH_CSV_TO_BIN, &BATCH_BIN_TO_CSV }) {
+        if (mode == *known) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Стадии те же, что у одиночного запуска утилит, но чтение и запись идут через буферы потока
+static void ProcessJob(const BatchJob& job, BatchWorkspace& workspace, const BatchOptions& options, JobResult& result) {
+    using Clock = chrono::steady_clock;
+    auto elapsedMs = [](Clock::time_point from) {
+        return chrono::duration<double, milli>(Clock::now() - from).count();
+    };
+    auto start = Clock::now();
+    if (!ReadWholeFile(job.input, workspace.input)) {
+        result.error = "could not read input";
+        return;
+    }
+    result.readMs = elapsedMs(start);
+
+    start = Clock::now();
+    const string& mode = job.mode;
+    AutomataFormat format = FormatFor(job.output);
+    AutomataFileKind kind = DetectAutomataData(workspace.input);
+    bool minimizeFirst = mode == BATCH_MEALY_TO_MOORE_MIN || mode == BATCH_MOORE_TO_MEALY_MIN;
+    bool mealyInput = mode == BATCH_MEALY || mode == BATCH_MEALY_TO_MOORE || mode == BATCH_MEALY_TO_MOORE_MIN;
+    // csv2bin / bin2csv: тип автомата определяется по входу
+    if (mode == BATCH_CSV_TO_BIN || mode == BATCH_BIN_TO_CSV) {
+        bool binaryInput = kind == AutomataFileKind::MooreBinary || kind == AutomataFileKind::MealyBinary;
+        if (binaryInput != (mode == BATCH_BIN_TO_CSV)) {
+            result.error = binaryInput ? "input is already binary" : "input is not binary";
+            return;
+        }
+        mealyInput = kind == AutomataFileKind::MealyCsv || kind == AutomataFileKind::MealyBinary;
+        format = mode == BATCH_CSV_TO_BIN ? AutomataFormat::Binary : AutomataFormat::Csv;
+    }
+    if (mealyInput) {
+        MealyAutomata mealy;
+        if (!LoadMealyFromBuffer(workspace.input, mealy)) {
+            result.error = "could not parse input";
+            return;
+        }
+        if (mode == BATCH_MEALY_TO_MOORE || mode == BATCH_MEALY_TO_MOORE_MIN) {
+            RemoveUnreachableStatesMealy(mealy);
+            if (minimizeFirst) {
+                MinimizeMealy(mealy, options.engine);
+            }
+            MooreAutomata moore = AltConvertMealyToMoore(move(mealy));
+            if (minimizeFirst) {
+                MinimizeMoore(moore, options.engine);
+            }
+            result.states = moore.numStates;
+            SaveMooreToBuffer(moore, format, workspace.output);
+        }
+        else {
+            if (mode == BATCH_MEALY) {
+                RemoveUnreachableStatesMealy(mealy);
+                MinimizeMealy(mealy, options.engine);
+            }
+            result.states = mealy.numStates;
+            SaveMealyToBuffer(mealy, format, workspace.output);
+        }
+    }
+    else {
+        MooreAutomata moore;
+        if (!LoadMooreFromBuffer(workspace.input, moore)) {
+            result.error = "could not parse input";
+            return;
+        }
+        if (mode == BATCH_MOORE_TO_MEALY || mode == BATCH_MOORE_TO_MEALY_MIN) {
+            RemoveUnreachableStatesMoore(moore);
+            if (minimizeFirst) {
+                MinimizeMoore(moore, options.engine);
+            }
+            MealyAutomata mealy = ConvertMooreToMealy(move(moore));
+            if (minimizeFirst) {
+                MinimizeMealy(mealy, options.engine);
+            }
+            result.states = mealy.numStates;
+            SaveMealyToBuffer(mealy, format, workspace.output);
+        }
+        else {
+            if (mode == BATCH_MOORE) {
+                RemoveUnreachableStatesMoore(moore);
+                MinimizeMoore(moore, options.engine);
+            }
+            result.states = moore.numStates;
+            SaveMooreToBuffer(moore, format, workspace.output);
+        }
+    }
+    result.processMs = elapsedMs(start);
+
+    start = Clock::now();
+    if (!WriteWholeFile(job.output, workspace.output)) {
+        result.error = "could not write output";
+        return;
+    }
+    result.writeMs = elapsedMs(start);
+}
+
+static void AppendJsonString(ostringstream& out, const string& text) {
+    out << '"';
+    for (char ch : text) {
+        if (ch == '"' || ch == '\\') {
+            out << '\\' << ch;
+        }
+        else if (static_cast<unsigned char>(ch) < 0x20) {
+            out << "\\u" << hex << setw(4) << setfill('0') << int(ch) << dec << setfill(' ');
+        }
+        else {
+            out << ch;
+        }
+    }
+    out << '"';
+}
+
+static string FormatJobLine(const BatchJob& job, const JobResult& result, size_t worker, bool arenaStats) {
+    ostringstream out;
+    out << fixed << setprecision(3);
+    out << "{\"job\":" << job.id << ",\"line\":" << job.line << ",\"mode\":";
+    AppendJsonString(out, job.mode);
+    out << ",\"input\":";
+    AppendJsonString(out, job.input);
+    out << ",\"output\":";
+    AppendJsonString(out, job.output);
+    out << ",\"ok\":" << (result.error.empty() ? "true" : "false");
+    if (!result.error.empty()) {
+        out << ",\"error\":";
+        AppendJsonString(out, result.error);
+    }
+    out << ",\"states\":" << result.states << ",\"read_ms\":" << result.readMs << ",\"process_ms\":" << result.processMs
+        << ",\"write_ms\":" << result.writeMs << ",\"total_ms\":" << result.readMs + result.processMs + result.writeMs
+        << ",\"worker\":" << worker;
+    if (arenaStats) {
+        out << ",\"arena_peak_bytes\":" << result.arena.peakBytes << ",\"arena_allocations\":" << result.arena.allocations;
+    }
+    out << "}\n";
+    return out.str();
+}
+
+// Задания раздаются по мере чтения манифеста, поэтому режим годится и для долгоживущего процесса,
+// которому строки подаются в stdin
+bool RunBatch(istream& manifest, ostream& log, const BatchOptions& options) {
+    auto start = chrono::steady_clock::now();
+    mutex queueMutex, logMutex;
+    condition_variable queueReady;
+    deque<BatchJob> queue;
+    bool closed = false;
+    size_t failed = 0;
+    auto report = [&](const string& line, bool ok) {
+        lock_guard<mutex> lock(logMutex);
+        log << line << flush;
+        failed += ok ? 0 : 1;
+    };
+    auto worker = [&](size_t workerId) {
+        BatchWorkspace workspace;
+        Arena arena;
+        while (true) {
+            BatchJob job;
+            {
+                unique_lock<mutex> lock(queueMutex);
+                queueReady.wait(lock, [&]() { return closed || !queue.empty(); });
+                if (queue.empty()) {
+                    return;
+                }
+                job = move(queue.front());
+                queue.pop_front();
+            }
+            JobResult result;
+            {
+                ArenaScope scope(arena);
+                ProcessJob(job, workspace, options, result);
+            }
+            result.arena = arena.Stats();
+            arena.Release();
+            workspace.input.clear();
+            workspace.output.clear();
+            report(FormatJobLine(job, result, workerId, options.arenaStats), result.error.empty());
+        }
+    };
+    vector<thread> pool;
+    for (unsigned workerId = 0; workerId < max(1u, options.threads); workerId++) {
+        pool.emplace_back(worker, workerId);
+    }
+
+    size_t jobCount = 0;
+    size_t lineNumber = 0;
+    string line;
+    while (getline(manifest, line)) {
+        lineNumber++;
+        istringstream fields(line);
+        BatchJob job;
+        if (!(fields >> job.mode) || job.mode[0] == '#') {
+            continue;
+        }
+        job.id = jobCount++;
+        job.line = lineNumber;
+        string extra;
+        if (!(fields >> job.input >> job.output) || (fields >> extra) || !IsBatchMode(job.mode)) {
+            JobResult result;
+            result.error = IsBatchMode(job.mode) ? "expected <mode> <input_file> <output_file>" : "unknown mode";
+            report(FormatJobLine(job, result, 0, options.arenaStats), false);
+            continue;
+        }
+        {
+            lock_guard<mutex> lock(queueMutex);
+            queue.push_back(move(job));
+        }
+        queueReady.notify_one();
+    }
+    {
+        lock_guard<mutex> lock(queueMutex);
+        closed = true;
+    }
+    queueReady.notify_all();
+    for (auto& thread : pool) {
+        thread.join();
+    }
+
+    double totalMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    ostringstream summary;
+    summary << fixed << setprecision(3) << "{\"jobs\":" << jobCount << ",\"failed\":" << failed
+        << ",\"total_ms\":" << totalMs << "}\n";
+    report(summary.str(), true);
+    return failed == 0;
+}
@@ -0,0 +1,22 @@
+﻿#pragma once
+
+#include <iosfwd>
+#include <string>
+
+#include "AutomataCore.h"
+
+// Пакетный режим: строки "<mode> <input_file> <output_file>" (из файла-манифеста или stdin)
+// выполняются на пуле потоков без запуска процесса на каждый автомат.
+// Режимы - mealy, moore (минимизация), mealy-to-moore, moore-to-mealy, mealy-to-moore-min,
+// moore-to-mealy-min, csv2bin, bin2csv. Пустые строки и строки с '#' пропускаются.
+// По каждому заданию в log пишется строка JSON с временем стадий
+// У каждого потока своя арена, она освобождается после каждого задания
+struct BatchOptions {
+    unsigned threads = 1;
+    MinimizationEngine engine = MinimizationEngine::Hopcroft;
+    // добавить в строку задания пик памяти арены и число выделений
+    bool arenaStats = false;
+};
+
+// false, если хотя бы одно задание не выполнено
+bool RunBatch(std::istream& manifest, std::ostream& log, const BatchOptions& options);
@@ -0,0 +1,435 @@
+﻿#include "AutomataCore.h"
+#include "MappedFile.h"
+#include "OutputBuffer.h"
+
+#include <cstring>
+#include <iostream>
+
+using namespace std;
+
+// Формат файла (little-endian, все секции выровнены на 8 байт):
+//   заголовок: "AUTM", версия, тип (0 - Мур, 1 - Мили), numStates, numInputs, резерв
+//   три таблицы имён (состояния, входы, выходы):
+//     count, poolSize, slotCount (uint64_t), offsets[count + 1] (uint64_t), slots (uint32_t), pool
+//   next[numStates * numInputs] (uint32_t)
+//   outputs: numStates для Мура, numStates * numInputs для Мили (uint32_t)
+const char BINARY_MAGIC[4] = { 'A', 'U', 'T', 'M' };
+const uint32_t MOORE_KIND = 0;
+const uint32_t MEALY_KIND = 1;
+const string BUFFER_SOURCE = "<buffer>";
+
+struct BinaryHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t kind;
+    uint32_t numStates;
+    uint32_t numInputs;
+    uint32_t reserved;
+};
+
+static void AppendBytes(OutputBuffer& file, const void* data, size_t size) {
+    file.Append(string_view(static_cast<const char*>(data), size));
+}
+
+static void AppendPadding(OutputBuffer& file, size_t size) {
+    for (size_t i = size; i % 8 != 0; i++) {
+        file.Append('\0');
+    }
+}
+
+static void WriteSymbolTable(OutputBuffer& file, const SymbolTable& table) {
+    uint64_t sizes[3] = { SymbolCount(table), table.pool.size(), table.slots.size() };
+    AppendBytes(file, sizes, sizeof(sizes));
+    for (size_t offset : table.offsets) {
+        uint64_t value = offset;
+        AppendBytes(file, &value, sizeof(value));
+    }
+    AppendBytes(file, table.slots.data(), table.slots.size() * sizeof(uint32_t));
+    AppendPadding(file, table.slots.size() * sizeof(uint32_t));
+    AppendBytes(file, table.pool.data(), table.pool.size());
+    AppendPadding(file, table.pool.size());
+}
+
+static void WriteIds(OutputBuffer& file, const pmr::vector<uint32_t>& ids) {
+    AppendBytes(file, ids.data(), ids.size() * sizeof(uint32_t));
+    AppendPadding(file, ids.size() * sizeof(uint32_t));
+}
+
+template <typename Automata>
+static void WriteBinary(const Automata& automata, uint32_t kind, OutputBuffer& file) {
+    BinaryHeader header = {};
+    memcpy(header.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC));
+    header.version = BINARY_FORMAT_VERSION;
+    header.kind = kind;
+    header.numStates = automata.numStates;
+    header.numInputs = automata.numInputs;
+    AppendBytes(file, &header, sizeof(header));
+    WriteSymbolTable(file, automata.states);
+    WriteSymbolTable(file, automata.inputs);
+    WriteSymbolTable(file, automata.outputSymbols);
+    WriteIds(file, automata.next);
+    WriteIds(file, automata.outputs);
+}
+
+template <typename Automata>
+static bool SaveBinary(const Automata& automata, uint32_t kind, const string& filename) {
+    OutputBuffer file(filename);
+    if (!file.IsOpen()) {
+        cerr << "Failed to open file: " << filename << endl;
+        return false;
+    }
+    WriteBinary(automata, kind, file);
+    if (!file.Close()) {
+        cerr << "Failed to write file: " << filename << endl;
+        return false;
+    }
+    return true;
+}
+
+void WriteMooreBinary(const MooreAutomata& automata, OutputBuffer& file) {
+    WriteBinary(automata, MOORE_KIND, file);
+}
+
+void WriteMealyBinary(const MealyAutomata& automata, OutputBuffer& file) {
+    WriteBinary(automata, MEALY_KIND, file);
+}
+
+template <typename Automata>
+static string ToBinary(const Automata& automata, uint32_t kind) {
+    string data;
+    OutputBuffer buffer(data);
+    WriteBinary(automata, kind, buffer);
+    buffer.Close();
+    return data;
+}
+
+bool SaveMooreBinary(const MooreAutomata& automata, const string& filename) {
+    return SaveBinary(automata, MOORE_KIND, filename);
+}
+
+bool SaveMealyBinary(const MealyAutomata& automata, const string& filename) {
+    return SaveBinary(automata, MEALY_KIND, filename);
+}
+
+string MooreToBinary(const MooreAutomata& automata) {
+    return ToBinary(automata, MOORE_KIND);
+}
+
+string MealyToBinary(const MealyAutomata& automata) {
+    return ToBinary(automata, MEALY_KIND);
+}
+
+// Последовательное чтение секций с проверкой границ файла
+struct BinaryCursor {
+    string_view data;
+    size_t pos = 0;
+    bool failed = false;
+};
+
+static const char* TakeBytes(BinaryCursor& cursor, size_t size) {
+    size_t padded = size + (8 - size % 8) % 8;
+    if (cursor.failed || padded < size || cursor.data.size() - cursor.pos < padded) {
+        cursor.failed = true;
+        return nullptr;
+    }
+    const char* bytes = cursor.data.data() + cursor.pos;
+    cursor.pos += padded;
+    return bytes;
+}
+
+static bool ReadIds(BinaryCursor& cursor, pmr::vector<uint32_t>& ids, uint64_t count) {
+    if (count > cursor.data.size() / sizeof(uint32_t)) {
+        cursor.failed = true;
+        return false;
+    }
+    const char* bytes = TakeBytes(cursor, count * sizeof(uint32_t));
+    if (bytes == nullptr) {
+        return false;
+    }
+    ids.resize(count);
+    memcpy(ids.data(), bytes, count * sizeof(uint32_t));
+    return true;
+}
+
+static bool ReadSymbolTable(BinaryCursor& cursor, SymbolTable& table) {
+    const char* sizesBytes = TakeBytes(cursor, 3 * sizeof(uint64_t));
+    if (sizesBytes == nullptr) {
+        return false;
+    }
+    uint64_t sizes[3];
+    memcpy(sizes, sizesBytes, sizeof(sizes));
+    uint64_t count = sizes[0], poolSize = sizes[1], slotCount = sizes[2];
+    // в индексе должна оставаться свободная ячейка, иначе поиск не остановится
+    if (count >= NO_SYMBOL || count > cursor.data.size() / sizeof(uint64_t)
+        || (slotCount & (slotCount - 1)) != 0 || (slotCount != 0 && slotCount <= count)) {
+        return false;
+    }
+    const char* offsetsBytes = TakeBytes(cursor, (count + 1) * sizeof(uint64_t));
+    if (offsetsBytes == nullptr || !ReadIds(cursor, table.slots, slotCount)) {
+        return false;
+    }
+    table.offsets.resize(count + 1);
+    for (size_t i = 0; i <= count; i++) {
+        uint64_t offset;
+        memcpy(&offset, offsetsBytes + i * sizeof(uint64_t), sizeof(offset));
+        if (offset > poolSize || (i == 0 ? offset != 0 : offset < table.offsets[i - 1])) {
+            return false;
+        }
+        table.offsets[i] = offset;
+    }
+    if (table.offsets[count] != poolSize) {
+        return false;
+    }
+    bool hasFreeSlot = false;
+    for (uint32_t slot : table.slots) {
+        if (slot > count) {
+            return false;
+        }
+        hasFreeSlot = hasFreeSlot || slot == 0;
+    }
+    if (slotCount != 0 && !hasFreeSlot) {
+        return false;
+    }
+    if (count != 0 && slotCount == 0) {
+        return false;
+    }
+    const char* pool = TakeBytes(cursor, poolSize);
+    if (pool == nullptr) {
+        return false;
+    }
+    table.pool.assign(pool, poolSize);
+    return true;
+}
+
+static bool CheckIds(const pmr::vector<uint32_t>& ids, uint32_t limit) {
+    for (uint32_t id : ids) {
+        if (id != NO_STATE && id >= limit) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// source - имя файла или "<buffer>" для сообщений об ошибках.
+// При ошибке aut остаётся пустым: пустой автомат сам по себе ошибку не отличает
+template <typename Automata>
+static bool ParseBinary(uint32_t kind, string_view data, const string& source, Automata& aut) {
+    aut = Automata();
+    BinaryCursor cursor = { data };
+    const char* headerBytes = TakeBytes(cursor, sizeof(BinaryHeader));
+    if (headerBytes == nullptr || memcmp(headerBytes, BINARY_MAGIC, sizeof(BINARY_MAGIC)) != 0) {
+        cerr << "Error: Not a binary automaton file " << source << endl;
+        return false;
+    }
+    BinaryHeader header;
+    memcpy(&header, headerBytes, sizeof(header));
+    if (header.version != BINARY_FORMAT_VERSION) {
+        cerr << "Error: Unsupported binary format version " << header.version << " in " << source << endl;
+        return false;
+    }
+    if (header.kind != kind) {
+        cerr << "Error: Wrong automaton type in " << source << endl;
+        return false;
+    }
+    size_t cells = size_t(header.numStates) * header.numInputs;
+    size_t outputCount = kind == MOORE_KIND ? header.numStates : cells;
+    bool valid = ReadSymbolTable(cursor, aut.states)
+        && ReadSymbolTable(cursor, aut.inputs)
+        && ReadSymbolTable(cursor, aut.outputSymbols)
+        && SymbolCount(aut.states) == header.numStates
+        && SymbolCount(aut.inputs) == header.numInputs
+        && ReadIds(cursor, aut.next, cells)
+        && ReadIds(cursor, aut.outputs, outputCount)
+        && CheckIds(aut.next, header.numStates)
+        && CheckIds(aut.outputs, SymbolCount(aut.outputSymbols));
+    if (!valid) {
+        cerr << "Error: Corrupted binary automaton file " << source << endl;
+        aut = Automata();
+        return false;
+    }
+    aut.numStates = header.numStates;
+    aut.numInputs = header.numInputs;
+    return true;
+}
+
+template <typename Automata>
+static bool LoadBinary(uint32_t kind, const string& filename, Automata& aut) {
+    MappedFile file(filename);
+    if (!file.IsOpen()) {
+        cerr << "Error: Could not open file " << filename << endl;
+        aut = Automata();
+        return false;
+    }
+    return ParseBinary(kind, file.Data(), filename, aut);
+}
+
+MooreAutomata LoadMooreBinary(const string& filename) {
+    MooreAutomata automata;
+    LoadBinary(MOORE_KIND, filename, automata);
+    return automata;
+}
+
+MealyAutomata LoadMealyBinary(const string& filename) {
+    MealyAutomata automata;
+    LoadBinary(MEALY_KIND, filename, automata);
+    return automata;
+}
+
+static bool IsBinaryData(string_view data) {
+    return data.size() >= sizeof(BINARY_MAGIC) && memcmp(data.data(), BINARY_MAGIC, sizeof(BINARY_MAGIC)) == 0;
+}
+
+AutomataFileKind DetectAutomataData(string_view data) {
+    if (data.size() >= sizeof(BinaryHeader) && IsBinaryData(data)) {
+        BinaryHeader header;
+        memcpy(&header, data.data(), sizeof(header));
+        return header.kind == MEALY_KIND ? AutomataFileKind::MealyBinary : AutomataFileKind::MooreBinary;
+    }
+    // У Мура вторая строка - имена состояний и начинается с ';', у Мили - с имени входа
+    size_t lineEnd = data.find('\n');
+    if (lineEnd != string_view::npos && lineEnd + 1 < data.size() && data[lineEnd + 1] == ';') {
+        return AutomataFileKind::MooreCsv;
+    }
+    return AutomataFileKind::MealyCsv;
+}
+
+AutomataFileKind DetectAutomataFile(const string& filename) {
+    MappedFile file(filename);
+    if (!file.IsOpen()) {
+        return AutomataFileKind::Missing;
+    }
+    return DetectAutomataData(file.Data());
+}
+
+bool IsBinaryFileName(const string& filename) {
+    const string extension = ".bin";
+    return filename.size() >= extension.size()
+        && filename.compare(filename.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+bool LoadMooreFromBuffer(string_view data, MooreAutomata& automata, unsigned threads) {
+    if (IsBinaryData(data)) {
+        return ParseBinary(MOORE_KIND, data, BUFFER_SOURCE, automata);
+    }
+    automata = ParseMooreCsv(data, threads);
+    return true;
+}
+
+bool LoadMealyFromBuffer(string_view data, MealyAutomata& automata, unsigned threads) {
+    if (IsBinaryData(data)) {
+        return ParseBinary(MEALY_KIND, data, BUFFER_SOURCE, automata);
+    }
+    automata = ParseMealyCsv(data, threads);
+    return true;
+}
+
+// Файл отображается один раз, формат определяется по первым байтам.
+// Бинарный файл другого типа тоже разбирается как бинарный, чтобы сообщить об ошибке
+bool LoadMoore(const string& filename, MooreAutomata& automata, unsigned threads) {
+    MappedFile file(filename);
+    if (!file.IsOpen()) {
+        cerr << "Error: Could not open file " << filename << endl;
+        automata = MooreAutomata();
+        return false;
+    }
+    if (IsBinaryData(file.Data())) {
+        return ParseBinary(MOORE_KIND, file.Data(), filename, automata);
+    }
+    automata = ParseMooreCsv(file.Data(), threads);
+    return true;
+}
+
+bool LoadMealy(const string& filename, MealyAutomata& automata, unsigned threads) {
+    MappedFile file(filename);
+    if (!file.IsOpen()) {
+        cerr << "Error: Could not open file " << filename << endl;
+        automata = MealyAutomata();
+        return false;
+    }
+    if (IsBinaryData(file.Data())) {
+        return ParseBinary(MEALY_KIND, file.Data(), filename, automata);
+    }
+    automata = ParseMealyCsv(file.Data(), threads);
+    return true;
+}
+
+bool SaveMoore(const MooreAutomata& automata, const string& filename) {
+    if (IsBinaryFileName(filename)) {
+        return SaveMooreBinary(automata, filename);
+    }
+    return ExportMooreToCSV(automata, filename);
+}
+
+bool SaveMealy(const MealyAutomata& automata, const string& filename) {
+    if (IsBinaryFileName(filename)) {
+        return SaveMealyBinary(automata, filename);
+    }
+    return ExportMealyToCSV(automata, filename);
+}
+
+bool ConvertCsvToBinary(const string& inputFile, const string& outputFile, unsigned threads) {
+    switch (DetectAutomataFile(inputFile)) {
+    case AutomataFileKind::MooreCsv:
+        return SaveMooreBinary(ReadMoore(inputFile, threads), outputFile);
+    case AutomataFileKind::MealyCsv:
+        return SaveMealyBinary(ReadMealy(inputFile, threads), outputFile);
+    case AutomataFileKind::Missing:
+        cerr << "Error: Could not open file " << inputFile << endl;
+        return false;
+    default:
+        cerr << "Error: File is already binary " << inputFile << endl;
+        return false;
+    }
+}
+
+// Испорченный файл не превращается в пустую таблицу: выход не пишется
+bool ConvertBinaryToCsv(const string& inputFile, const string& outputFile) {
+    switch (DetectAutomataFile(inputFile)) {
+    case AutomataFileKind::MooreBinary: {
+        MooreAutomata automata;
+        return LoadBinary(MOORE_KIND, inputFile, automata) && ExportMooreToCSV(automata, outputFile);
+    }
+    case AutomataFileKind::MealyBinary: {
+        MealyAutomata automata;
+        return LoadBinary(MEALY_KIND, inputFile, automata) && ExportMealyToCSV(automata, outputFile);
+    }
+    case AutomataFileKind::Missing:
+        cerr << "Error: Could not open file " << inputFile << endl;
+        return false;
+    default:
+        cerr << "Error: Not a binary automaton file " << inputFile << endl;
+        return false;
+    }
+}
+
+string SaveMooreToBuffer(const MooreAutomata& automata, AutomataFormat format) {
+    return format == AutomataFormat::Binary ? MooreToBinary(automata) : MooreToCsv(automata);
+}
+
+string SaveMealyToBuffer(const MealyAutomata& automata, AutomataFormat format) {
+    return format == AutomataFormat::Binary ? MealyToBinary(automata) : MealyToCsv(automata);
+}
+
+void SaveMooreToBuffer(const MooreAutomata& automata, AutomataFormat format, string& target) {
+    target.clear();
+    OutputBuffer buffer(target);
+    if (format == AutomataFormat::Binary) {
+        WriteMooreBinary(automata, buffer);
+    }
+    else {
+        WriteMooreCsv(automata, buffer);
+    }
+    buffer.Close();
+}
+
+void SaveMealyToBuffer(const MealyAutomata& automata, AutomataFormat format, string& target) {
+    target.clear();
+    OutputBuffer buffer(target);
+    if (format == AutomataFormat::Binary) {
+        WriteMealyBinary(automata, buffer);
+    }
+    else {
+        WriteMealyCsv(automata, buffer);
+    }
+    buffer.Close();
+}
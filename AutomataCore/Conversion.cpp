@@ -0,0 +1,186 @@
+﻿#include "AutomataCore.h"
+
+#include <algorithm>
+#include <iostream>
+
+using namespace std;
+
+const string MOORE_STATE_CH = "q";
+
+// Таблицы имён и переходов забираются из автомата Мура без копирования
+MealyAutomata ConvertMooreToMealy(MooreAutomata&& moore) {
+    MealyAutomata mealy;
+
+    mealy.states = move(moore.states);
+    mealy.inputs = move(moore.inputs);
+    mealy.outputSymbols = move(moore.outputSymbols);
+    mealy.numStates = moore.numStates;
+    mealy.numInputs = moore.numInputs;
+    mealy.next = move(moore.next);
+    mealy.outputs.resize(mealy.next.size(), NO_SYMBOL);
+    // Заполняем таблицу переходов автомата Мили
+    for (size_t cell = 0; cell < mealy.next.size(); cell++) {
+        // Выход перехода - выход состояния, в которое ведёт переход
+        uint32_t nextState = mealy.next[cell];
+        if (nextState != NO_STATE)
+        {
+            mealy.outputs[cell] = moore.outputs[nextState];
+        }
+    }
+    return mealy;
+}
+
+// Порядковый номер выходного символа при сортировке по имени
+static pmr::vector<uint32_t> RankOutputsByName(const SymbolTable& outputSymbols, pmr::memory_resource* arena) {
+    uint32_t count = SymbolCount(outputSymbols);
+    pmr::vector<uint32_t> byName(count, arena);
+    for (uint32_t output = 0; output < count; output++) {
+        byName[output] = output;
+    }
+    sort(byName.begin(), byName.end(), [&](uint32_t a, uint32_t b) {
+        return SymbolName(outputSymbols, a) < SymbolName(outputSymbols, b);
+    });
+    pmr::vector<uint32_t> rank(count, arena);
+    for (uint32_t i = 0; i < count; i++) {
+        rank[byName[i]] = i;
+    }
+    return rank;
+}
+
+// Каждое состояние Мили расщепляется на копии - по одной на каждый различный выход входящих переходов,
+// копии упорядочены по имени выхода. Состояния Мура нумеруются по первой встрече при обходе строк,
+// начиная с первого состояния. Всё делается за O(n·k + m) без ассоциативных контейнеров
+MooreAutomata AltConvertMealyToMoore(MealyAutomata&& mealy)
+{
+    MooreAutomata moore;
+
+    moore.inputs = move(mealy.inputs);
+    moore.outputSymbols = move(mealy.outputSymbols);
+    moore.numInputs = mealy.numInputs;
+    if (mealy.numStates == 0) {
+        return moore;
+    }
+    size_t inputs = mealy.numInputs;
+    size_t cells = mealy.next.size();
+    if (cells >= NO_STATE) {
+        cerr << "Error: Automaton is too large to convert" << endl;
+        return MooreAutomata();
+    }
+    // Пустой выход перехода (NO_SYMBOL) - такой же выход "", как у ReadMoore: своя копия состояния
+    // и место в сортировке по имени
+    uint32_t emptyOutput = NO_SYMBOL;
+    for (size_t cell = 0; cell < cells; cell++) {
+        if (mealy.next[cell] != NO_STATE && mealy.outputs[cell] == NO_SYMBOL) {
+            if (emptyOutput == NO_SYMBOL) {
+                emptyOutput = InternSymbol(moore.outputSymbols, "");
+            }
+            mealy.outputs[cell] = emptyOutput;
+        }
+    }
+    // Рабочие массивы и карты копий берутся из арены потока
+    pmr::memory_resource* arena = CurrentArena();
+    // Переходы, сгруппированные по выходу в порядке имён (сортировка подсчётом)
+    pmr::vector<uint32_t> rank = RankOutputsByName(moore.outputSymbols, arena);
+    uint32_t outputCount = SymbolCount(moore.outputSymbols);
+    pmr::vector<uint32_t> outputStart(size_t(outputCount) + 1, 0, arena);
+    for (size_t cell = 0; cell < cells; cell++) {
+        if (mealy.next[cell] != NO_STATE) {
+            outputStart[rank[mealy.outputs[cell]] + 1]++;
+        }
+    }
+    for (uint32_t i = 0; i < outputCount; i++) {
+        outputStart[i + 1] += outputStart[i];
+    }
+    pmr::vector<uint32_t> byOutput(outputStart.back(), arena);
+    {
+        pmr::vector<uint32_t> fillPos(outputStart.begin(), outputStart.end() - 1, arena);
+        for (size_t cell = 0; cell < cells; cell++) {
+            if (mealy.next[cell] != NO_STATE) {
+                byOutput[fillPos[rank[mealy.outputs[cell]]]++] = uint32_t(cell);
+            }
+        }
+    }
+    // Плотный индекс (состояние, выход) -> номер копии: выходы идут по возрастанию имени,
+    // поэтому новая копия появляется, когда у целевого состояния меняется последний выход.
+    // copyOf[cell] - номер копии целевого состояния, в которую ведёт переход
+    pmr::vector<uint32_t> copyCount(mealy.numStates, 0, arena), lastOutput(mealy.numStates, NO_SYMBOL, arena);
+    pmr::vector<uint32_t> copyOf(cells, NO_STATE, arena);
+    for (uint32_t cell : byOutput) {
+        uint32_t target = mealy.next[cell];
+        uint32_t output = mealy.outputs[cell];
+        if (lastOutput[target] != output) {
+            lastOutput[target] = output;
+            copyCount[target]++;
+        }
+        copyOf[cell] = copyCount[target] - 1;
+    }
+    // выходы копий: copyOutputs[copyStart[state] + copy]
+    pmr::vector<uint32_t> copyStart(size_t(mealy.numStates) + 1, 0, arena);
+    for (uint32_t state = 0; state < mealy.numStates; state++) {
+        copyStart[state + 1] = copyStart[state] + copyCount[state];
+    }
+    pmr::vector<uint32_t> copyOutputs(copyStart.back(), arena);
+    for (uint32_t cell : byOutput) {
+        uint32_t target = mealy.next[cell];
+        copyOutputs[copyStart[target] + copyOf[cell]] = mealy.outputs[cell];
+    }
+    byOutput = pmr::vector<uint32_t>(arena);
+    // назначаем для первого состояния
+    if (copyCount[0] == 0) {
+        copyOutputs.insert(copyOutputs.begin(), InternSymbol(moore.outputSymbols, BLANK_OUTPUT_CH));
+        for (uint32_t state = 1; state <= mealy.numStates; state++) {
+            copyStart[state]++;
+        }
+        copyCount[0] = 1;
+    }
+    bool needNewStates = any_of(copyCount.begin(), copyCount.end(), [](uint32_t count) { return count > 1; });
+    if (!needNewStates) {
+        moore.states = move(mealy.states);
+        moore.numStates = mealy.numStates;
+        moore.next = move(mealy.next);
+        moore.outputs.assign(mealy.numStates, NO_SYMBOL);
+        for (uint32_t state = 0; state < mealy.numStates; state++) {
+            if (copyCount[state] != 0) {
+                moore.outputs[state] = copyOutputs[copyStart[state]];
+            }
+        }
+        return moore;
+    }
+    // первая копия каждого состояния Мили в порядке первой встречи
+    pmr::vector<uint32_t> firstMooreState(mealy.numStates, NO_STATE, arena);
+    pmr::vector<uint32_t> orderedMealyStates(arena);
+    uint32_t mooreStateNum = 0;
+    auto addMooreStates = [&](uint32_t mealyState) {
+        orderedMealyStates.push_back(mealyState);
+        firstMooreState[mealyState] = mooreStateNum;
+        mooreStateNum += copyCount[mealyState];
+    };
+    addMooreStates(0);
+    for (size_t cell = 0; cell < cells; cell++) {
+        uint32_t target = mealy.next[cell];
+        if (target != NO_STATE && firstMooreState[target] == NO_STATE) {
+            addMooreStates(target);
+        }
+    }
+    moore.numStates = mooreStateNum;
+    GenerateSymbols(moore.states, MOORE_STATE_CH, mooreStateNum);
+    moore.next.resize(size_t(mooreStateNum) * inputs);
+    moore.outputs.resize(mooreStateNum);
+    for (uint32_t mealyState : orderedMealyStates) {
+        uint32_t first = firstMooreState[mealyState];
+        uint32_t* row = moore.next.data() + size_t(first) * inputs;
+        for (size_t input = 0; input < inputs; input++) {
+            size_t cell = mealyState * inputs + input;
+            uint32_t target = mealy.next[cell];
+            row[input] = target == NO_STATE ? NO_STATE : firstMooreState[target] + copyOf[cell];
+        }
+        // копии отличаются только выходом, переходы у них одинаковые
+        for (uint32_t copy = 0; copy < copyCount[mealyState]; copy++) {
+            if (copy != 0) {
+                copy_n(row, inputs, row + copy * inputs);
+            }
+            moore.outputs[first + copy] = copyOutputs[copyStart[mealyState] + copy];
+        }
+    }
+    return moore;
+}
@@ -0,0 +1,293 @@
+﻿#include "AutomataCore.h"
+#include "MappedFile.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+
+using namespace std;
+
+// Разбор CSV прямо в отображённом в память файле: ячейки - string_view на буфер,
+// имена сразу переводятся в идентификаторы без создания строк
+struct LineCursor {
+    const char* pos;
+    const char* end;
+};
+
+struct CellCursor {
+    const char* pos;
+    const char* end;
+};
+
+static bool NextLine(LineCursor& cursor, string_view& line) {
+    if (cursor.pos >= cursor.end) {
+        return false;
+    }
+    const char* lineEnd = static_cast<const char*>(memchr(cursor.pos, '\n', cursor.end - cursor.pos));
+    if (lineEnd == nullptr) {
+        lineEnd = cursor.end;
+    }
+    line = string_view(cursor.pos, lineEnd - cursor.pos);
+    if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+    }
+    cursor.pos = lineEnd + 1;
+    return true;
+}
+
+// Как getline(ss, cell, ';'): пустой хвост после последнего ';' ячейкой не считается
+static bool NextCell(CellCursor& cursor, string_view& cell) {
+    if (cursor.pos >= cursor.end) {
+        return false;
+    }
+    const char* cellEnd = static_cast<const char*>(memchr(cursor.pos, ';', cursor.end - cursor.pos));
+    if (cellEnd == nullptr) {
+        cellEnd = cursor.end;
+    }
+    cell = string_view(cursor.pos, cellEnd - cursor.pos);
+    cursor.pos = cellEnd + 1;
+    return true;
+}
+
+static CellCursor Cells(string_view line) {
+    return { line.data(), line.data() + line.size() };
+}
+
+static uint32_t CountRows(LineCursor cursor) {
+    uint32_t count = 0;
+    string_view line;
+    while (NextLine(cursor, line)) {
+        if (!line.empty()) {
+            count++;
+        }
+    }
+    return count;
+}
+
+static uint32_t ResolveState(const SymbolTable& states, string_view name) {
+    if (name.empty() || name == " ") {
+        return NO_STATE;
+    }
+    uint32_t state = FindSymbol(states, name);
+    if (state == NO_SYMBOL) {
+        static mutex errorMutex;
+        lock_guard<mutex> lock(errorMutex);
+        cerr << "Error: Unknown state " << name << endl;
+        return NO_STATE;
+    }
+    return state;
+}
+
+static void ReadStatesLine(string_view line, SymbolTable& states) {
+    ReserveSymbols(states, count(line.begin(), line.end(), ';'), line.size());
+    CellCursor cells = Cells(line);
+    string_view state;
+    NextCell(cells, state); // Пропуск первого столбца
+    while (NextCell(cells, state)) {
+        AddSymbol(states, state);
+    }
+}
+
+// Часть строк переходов, разбираемая одним потоком
+struct RowChunk {
+    LineCursor lines;
+    uint32_t firstRow = 0;
+    uint32_t rowCount = 0;
+    vector<string_view> inputs;
+    // выходы Мили, встреченные в этой части; номера локальные до слияния
+    SymbolTable outputSymbols;
+};
+
+// Делит буфер на части по границам строк
+static vector<RowChunk> SplitRows(LineCursor lines, size_t parts) {
+    vector<RowChunk> chunks;
+    const char* begin = lines.pos;
+    size_t total = lines.end > begin ? lines.end - begin : 0;
+    const char* pos = begin;
+    for (size_t part = 1; part <= parts && pos < lines.end; part++) {
+        const char* chunkEnd = part == parts ? lines.end : max(pos, begin + total * part / parts);
+        if (chunkEnd < lines.end) {
+            const char* lineEnd = static_cast<const char*>(memchr(chunkEnd, '\n', lines.end - chunkEnd));
+            chunkEnd = lineEnd == nullptr ? lines.end : lineEnd + 1;
+        }
+        RowChunk chunk;
+        chunk.lines = { pos, chunkEnd };
+        chunks.push_back(move(chunk));
+        pos = chunkEnd;
+    }
+    return chunks;
+}
+
+// Считает строки в каждой части и назначает им номера входов по порядку частей
+static uint32_t NumberRows(vector<RowChunk>& chunks, unsigned threads) {
+    RunParallel(chunks.size(), threads, [&](size_t i) {
+        chunks[i].rowCount = CountRows(chunks[i].lines);
+    });
+    uint32_t rows = 0;
+    for (auto& chunk : chunks) {
+        chunk.firstRow = rows;
+        rows += chunk.rowCount;
+    }
+    return rows;
+}
+
+static void ParseMooreRows(RowChunk& chunk, MooreAutomata& aut) {
+    size_t inputs = aut.numInputs;
+    uint32_t inputIndex = chunk.firstRow;
+    chunk.inputs.reserve(chunk.rowCount);
+    string_view line;
+    while (NextLine(chunk.lines, line))
+    {
+        if (line.empty()) {
+            continue;
+        }
+        CellCursor cells = Cells(line);
+        string_view input, transition;
+        NextCell(cells, input);
+        chunk.inputs.push_back(input);
+        for (size_t state = 0; state < aut.numStates && NextCell(cells, transition); state++)
+        {
+            aut.next[state * inputs + inputIndex] = ResolveState(aut.states, transition);
+        }
+        inputIndex++;
+    }
+}
+
+static void ParseMealyRows(RowChunk& chunk, MealyAutomata& aut) {
+    size_t inputs = aut.numInputs;
+    uint32_t inputIndex = chunk.firstRow;
+    chunk.inputs.reserve(chunk.rowCount);
+    string_view line;
+    while (NextLine(chunk.lines, line)) {
+        if (line.empty()) {
+            continue;
+        }
+        CellCursor cells = Cells(line);
+        string_view input, transition;
+        NextCell(cells, input);
+        chunk.inputs.push_back(input);
+        for (size_t state = 0; state < aut.numStates && NextCell(cells, transition); state++) {
+            size_t slash = transition.find('/');
+            string_view nextState = transition.substr(0, slash);
+            string_view output = slash == string_view::npos ? string_view() : transition.substr(slash + 1);
+            size_t cell = state * inputs + inputIndex;
+            aut.next[cell] = ResolveState(aut.states, nextState);
+            aut.outputs[cell] = output.empty() ? NO_SYMBOL : InternSymbol(chunk.outputSymbols, output);
+        }
+        inputIndex++;
+    }
+}
+
+static void MergeInputs(const vector<RowChunk>& chunks, SymbolTable& inputs) {
+    for (const auto& chunk : chunks) {
+        for (string_view input : chunk.inputs) {
+            AddSymbol(inputs, input);
+        }
+    }
+}
+
+// Сливает локальные таблицы выходов в порядке частей, поэтому номера выходов
+// совпадают с последовательным чтением
+static void MergeOutputSymbols(vector<RowChunk>& chunks, MealyAutomata& aut, unsigned threads) {
+    if (chunks.size() == 1) {
+        aut.outputSymbols = move(chunks[0].outputSymbols);
+        return;
+    }
+    vector<vector<uint32_t>> toGlobal(chunks.size());
+    for (size_t i = 0; i < chunks.size(); i++) {
+        const SymbolTable& local = chunks[i].outputSymbols;
+        for (uint32_t id = 0; id < SymbolCount(local); id++) {
+            toGlobal[i].push_back(InternSymbol(aut.outputSymbols, SymbolName(local, id)));
+        }
+    }
+    size_t inputs = aut.numInputs;
+    RunParallel(chunks.size(), threads, [&](size_t i) {
+        for (size_t state = 0; state < aut.numStates; state++) {
+            uint32_t* row = aut.outputs.data() + state * inputs;
+            for (uint32_t input = chunks[i].firstRow; input < chunks[i].firstRow + chunks[i].rowCount; input++) {
+                if (row[input] != NO_SYMBOL) {
+                    row[input] = toGlobal[i][row[input]];
+                }
+            }
+        }
+    });
+}
+
+static size_t ChunkCount(unsigned threads) {
+    // несколько частей на поток выравнивают нагрузку при строках разной длины
+    return threads <= 1 ? 1 : size_t(threads) * 4;
+}
+
+MooreAutomata ParseMooreCsv(string_view data, unsigned threads) {
+    MooreAutomata aut;
+    LineCursor lines = { data.data(), data.data() + data.size() };
+    string_view outputsLine, statesLine;
+    NextLine(lines, outputsLine);
+    NextLine(lines, statesLine);
+    // Чтение имен состояний
+    ReadStatesLine(statesLine, aut.states);
+    aut.numStates = SymbolCount(aut.states);
+    // Чтение выходных символов
+    aut.outputs.reserve(aut.numStates);
+    CellCursor outputCells = Cells(outputsLine);
+    string_view output;
+    NextCell(outputCells, output); // Пропуск первого столбца
+    while (aut.outputs.size() < aut.numStates) {
+        if (!NextCell(outputCells, output)) {
+            output = {};
+        }
+        aut.outputs.push_back(InternSymbol(aut.outputSymbols, output));
+    }
+    // Чтение переходов: каждая строка - отдельный вход, части разбираются независимо
+    vector<RowChunk> chunks = SplitRows(lines, ChunkCount(threads));
+    aut.numInputs = NumberRows(chunks, threads);
+    aut.next.assign(size_t(aut.numStates) * aut.numInputs, NO_STATE);
+    RunParallel(chunks.size(), threads, [&](size_t i) {
+        ParseMooreRows(chunks[i], aut);
+    });
+    MergeInputs(chunks, aut.inputs);
+    return aut;
+}
+
+MealyAutomata ParseMealyCsv(string_view data, unsigned threads) {
+    MealyAutomata mealyAutomata;
+    LineCursor lines = { data.data(), data.data() + data.size() };
+    // Чтение заголовка (состояния)
+    string_view statesLine;
+    NextLine(lines, statesLine);
+    ReadStatesLine(statesLine, mealyAutomata.states);
+    mealyAutomata.numStates = SymbolCount(mealyAutomata.states);
+    // Чтение переходов
+    vector<RowChunk> chunks = SplitRows(lines, ChunkCount(threads));
+    mealyAutomata.numInputs = NumberRows(chunks, threads);
+    size_t cells = size_t(mealyAutomata.numStates) * mealyAutomata.numInputs;
+    mealyAutomata.next.assign(cells, NO_STATE);
+    mealyAutomata.outputs.assign(cells, NO_SYMBOL);
+    RunParallel(chunks.size(), threads, [&](size_t i) {
+        ParseMealyRows(chunks[i], mealyAutomata);
+    });
+    MergeInputs(chunks, mealyAutomata.inputs);
+    MergeOutputSymbols(chunks, mealyAutomata, threads);
+    return mealyAutomata;
+}
+
+MooreAutomata ReadMoore(const string& inputFile, unsigned threads) {
+    MappedFile file(inputFile);
+    if (!file.IsOpen())
+    {
+        cerr << "Error: Could not open file " << inputFile << endl;
+        return MooreAutomata();
+    }
+    return ParseMooreCsv(file.Data(), threads);
+}
+
+MealyAutomata ReadMealy(const string& inputFile, unsigned threads) {
+    MappedFile file(inputFile);
+    if (!file.IsOpen()) {
+        cerr << "Error: Could not open file " << inputFile << endl;
+        return MealyAutomata();
+    }
+    return ParseMealyCsv(file.Data(), threads);
+}
@@ -0,0 +1,331 @@
+﻿#include "Nfa.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
+using namespace std;
+
+// ε-замыкания всех состояний: замыкание state - closure[offsets[state], offsets[state + 1]), по возрастанию
+static void ComputeClosures(const Nfa& nfa, pmr::vector<uint32_t>& offsets, pmr::vector<uint32_t>& closure) {
+    pmr::vector<uint32_t> seenBy(nfa.numStates, NO_STATE, CurrentArena());
+    vector<uint32_t> stack;
+    offsets.assign(1, 0);
+    for (uint32_t state = 0; state < nfa.numStates; state++) {
+        size_t begin = closure.size();
+        seenBy[state] = state;
+        closure.push_back(state);
+        stack.push_back(state);
+        while (!stack.empty()) {
+            uint32_t from = stack.back();
+            stack.pop_back();
+            for (uint32_t pos = nfa.epsilonOffsets[from]; pos < nfa.epsilonOffsets[from + 1]; pos++) {
+                uint32_t target = nfa.epsilonTargets[pos];
+                if (seenBy[target] != state) {
+                    seenBy[target] = state;
+                    closure.push_back(target);
+                    stack.push_back(target);
+                }
+            }
+        }
+        sort(closure.begin() + begin, closure.end());
+        offsets.push_back(static_cast<uint32_t>(closure.size()));
+    }
+}
+
+static uint64_t HashSubset(const uint32_t* begin, const uint32_t* end) {
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (const uint32_t* pos = begin; pos != end; pos++) {
+        hash = (hash ^ *pos) * 0x100000001B3ULL;
+    }
+    return hash ^ (hash >> 29);
+}
+
+// Множество подмножеств с хеш-консингом: элементы подряд в pool,
+// открытая адресация по номерам подмножеств (номер + 1, 0 - свободно)
+struct SubsetTable {
+    pmr::vector<uint32_t> pool{ CurrentArena() };
+    pmr::vector<size_t> offsets{ initializer_list<size_t>{ 0 }, CurrentArena() };
+    pmr::vector<uint64_t> hashes{ CurrentArena() };
+    pmr::vector<uint32_t> slots{ CurrentArena() };
+
+    uint32_t Count() const {
+        return static_cast<uint32_t>(hashes.size());
+    }
+};
+
+static void RehashSubsets(SubsetTable& table, size_t capacity) {
+    table.slots.assign(capacity, 0);
+    size_t mask = capacity - 1;
+    for (uint32_t id = 0; id < table.Count(); id++) {
+        size_t slot = table.hashes[id] & mask;
+        while (table.slots[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        table.slots[slot] = id + 1;
+    }
+}
+
+// Номер подмножества [begin, end) с хешем hash, новое добавляется в конец
+static uint32_t InternSubset(SubsetTable& table, const uint32_t* begin, const uint32_t* end, uint64_t hash) {
+    if ((size_t(table.Count()) + 1) * 2 > table.slots.size()) {
+        RehashSubsets(table, max<size_t>(1024, table.slots.size() * 2));
+    }
+    size_t mask = table.slots.size() - 1;
+    size_t slot = hash & mask;
+    size_t length = end - begin;
+    while (table.slots[slot] != 0) {
+        uint32_t id = table.slots[slot] - 1;
+        const uint32_t* stored = table.pool.data() + table.offsets[id];
+        if (table.hashes[id] == hash && table.offsets[id + 1] - table.offsets[id] == length && equal(begin, end, stored)) {
+            return id;
+        }
+        slot = (slot + 1) & mask;
+    }
+    uint32_t id = table.Count();
+    table.slots[slot] = id + 1;
+    table.hashes.push_back(hash);
+    table.pool.insert(table.pool.end(), begin, end);
+    table.offsets.push_back(table.pool.size());
+    return id;
+}
+
+static uint32_t InternSubset(SubsetTable& table, const uint32_t* begin, const uint32_t* end) {
+    return InternSubset(table, begin, end, HashSubset(begin, end));
+}
+
+// Объединение ε-замыканий целей переходов из подмножества [begin, end) по input, по возрастанию.
+// collectedIn - метка последнего сбора, в который попало состояние НКА: объединение без повторов за один проход
+static void CollectTargets(const Nfa& nfa, const pmr::vector<uint32_t>& closureOffsets, const pmr::vector<uint32_t>& closure,
+    const uint32_t* begin, const uint32_t* end, uint32_t input,
+    pmr::vector<uint64_t>& collectedIn, uint64_t collection, vector<uint32_t>& collected)
+{
+    collected.clear();
+    for (const uint32_t* pos = begin; pos != end; pos++) {
+        size_t cell = size_t(*pos) * nfa.numInputs + input;
+        for (uint32_t edge = nfa.offsets[cell]; edge < nfa.offsets[cell + 1]; edge++) {
+            uint32_t target = nfa.targets[edge];
+            for (uint32_t member = closureOffsets[target]; member < closureOffsets[target + 1]; member++) {
+                uint32_t state = closure[member];
+                if (collectedIn[state] != collection) {
+                    collectedIn[state] = collection;
+                    collected.push_back(state);
+                }
+            }
+        }
+    }
+    sort(collected.begin(), collected.end());
+}
+
+static uint32_t SubsetOutput(const Nfa& nfa, const uint32_t* begin, const uint32_t* end) {
+    uint32_t output = NO_SYMBOL;
+    for (const uint32_t* pos = begin; pos != end; pos++) {
+        output = min(output, nfa.outputs[*pos]);
+    }
+    return output;
+}
+
+static MooreAutomata DeterminizeSequential(const Nfa& nfa, const pmr::vector<uint32_t>& closureOffsets, const pmr::vector<uint32_t>& closure) {
+    MooreAutomata dfa;
+    SubsetTable subsets;
+    InternSubset(subsets, closure.data() + closureOffsets[0], closure.data() + closureOffsets[1]);
+    pmr::vector<uint64_t> collectedIn(nfa.numStates, 0, CurrentArena());
+    uint64_t collection = 0;
+    vector<uint32_t> collected;
+    // Очередь обхода в ширину - сами номера подмножеств
+    for (uint32_t current = 0; current < subsets.Count(); current++) {
+        // pool растёт при добавлении, поэтому подмножество адресуется смещениями
+        size_t begin = subsets.offsets[current];
+        size_t end = subsets.offsets[current + 1];
+        dfa.outputs.push_back(SubsetOutput(nfa, subsets.pool.data() + begin, subsets.pool.data() + end));
+        for (uint32_t input = 0; input < nfa.numInputs; input++) {
+            CollectTargets(nfa, closureOffsets, closure, subsets.pool.data() + begin, subsets.pool.data() + end,
+                input, collectedIn, ++collection, collected);
+            if (collected.empty()) {
+                dfa.next.push_back(NO_STATE);
+                continue;
+            }
+            dfa.next.push_back(InternSubset(subsets, collected.data(), collected.data() + collected.size()));
+        }
+    }
+    dfa.numStates = subsets.Count();
+    return dfa;
+}
+
+const unsigned SUBSET_SHARD_BITS = 6;
+const size_t FRONTIER_BLOCK = 64;
+// Предварительный номер подмножества: номер в шарде << SUBSET_SHARD_BITS | шард
+const uint64_t NO_SUBSET = UINT64_MAX;
+
+struct SubsetShard {
+    mutex shardMutex;
+    SubsetTable table;
+    // строка подмножества в общей таблице переходов, выдаётся при постановке во фронт
+    pmr::vector<size_t> rows{ CurrentArena() };
+};
+
+// Подмножества, найденные одним потоком за уровень, - фронт следующего уровня
+struct FrontierPart {
+    vector<uint32_t> pool;
+    vector<size_t> offsets{ 0 };
+    vector<uint64_t> ids;
+};
+
+// Обход по уровням: подмножества фронта раскрываются блоками на threads потоках,
+// новые подмножества склеиваются в шардах по старшим битам хеша, у каждого шарда своя блокировка.
+// Переходы пишутся предварительными номерами, затем последовательный обход в ширину
+// по готовой таблице выдаёт те же номера, что и DeterminizeSequential
+static MooreAutomata DeterminizeParallel(const Nfa& nfa, const pmr::vector<uint32_t>& closureOffsets,
+    const pmr::vector<uint32_t>& closure, unsigned threads)
+{
+    const size_t shardCount = size_t(1) << SUBSET_SHARD_BITS;
+    const uint64_t shardMask = shardCount - 1;
+    uint32_t numInputs = nfa.numInputs;
+    vector<SubsetShard> shards(shardCount);
+    auto internShared = [&](const uint32_t* begin, const uint32_t* end, bool& inserted) {
+        uint64_t hash = HashSubset(begin, end);
+        size_t shard = size_t(hash >> (64 - SUBSET_SHARD_BITS));
+        SubsetTable& table = shards[shard].table;
+        lock_guard<mutex> lock(shards[shard].shardMutex);
+        uint32_t count = table.Count();
+        uint32_t id = InternSubset(table, begin, end, hash);
+        inserted = id == count;
+        return (uint64_t(id) << SUBSET_SHARD_BITS) | shard;
+    };
+
+    vector<FrontierPart> frontier(1);
+    const uint32_t* startBegin = closure.data() + closureOffsets[0];
+    const uint32_t* startEnd = closure.data() + closureOffsets[1];
+    bool inserted;
+    uint64_t start = internShared(startBegin, startEnd, inserted);
+    frontier[0].pool.assign(startBegin, startEnd);
+    frontier[0].offsets.push_back(frontier[0].pool.size());
+    frontier[0].ids.push_back(start);
+
+    // rowTargets[row * numInputs + input] - предварительный номер цели
+    pmr::vector<uint64_t> rowTargets(CurrentArena());
+    pmr::vector<uint32_t> rowOutputs(CurrentArena());
+    size_t rowCount = 0;
+    unsigned workers = max(1u, threads);
+    // метки сборов у каждого потока свои и продолжают счёт прошлых уровней
+    vector<pmr::vector<uint64_t>> collectedIn(workers, pmr::vector<uint64_t>(nfa.numStates, 0, CurrentArena()));
+    vector<uint64_t> collections(workers, 0);
+    vector<pair<size_t, size_t>> blocks;
+    vector<size_t> partRow;
+    while (true) {
+        blocks.clear();
+        partRow.clear();
+        size_t levelSize = 0;
+        for (size_t part = 0; part < frontier.size(); part++) {
+            partRow.push_back(rowCount + levelSize);
+            for (size_t begin = 0; begin < frontier[part].ids.size(); begin += FRONTIER_BLOCK) {
+                blocks.emplace_back(part, begin);
+            }
+            levelSize += frontier[part].ids.size();
+        }
+        if (levelSize == 0) {
+            break;
+        }
+        for (SubsetShard& shard : shards) {
+            shard.rows.resize(shard.table.Count());
+        }
+        for (size_t part = 0; part < frontier.size(); part++) {
+            for (size_t i = 0; i < frontier[part].ids.size(); i++) {
+                uint64_t id = frontier[part].ids[i];
+                shards[id & shardMask].rows[id >> SUBSET_SHARD_BITS] = partRow[part] + i;
+            }
+        }
+        rowTargets.resize((rowCount + levelSize) * numInputs);
+        rowOutputs.resize(rowCount + levelSize);
+
+        vector<FrontierPart> next(workers);
+        atomic<size_t> nextBlock{ 0 };
+        RunParallel(workers, workers, [&](size_t worker) {
+            FrontierPart& found = next[worker];
+            pmr::vector<uint64_t>& stamps = collectedIn[worker];
+            uint64_t collection = collections[worker];
+            vector<uint32_t> collected;
+            for (size_t block = nextBlock++; block < blocks.size(); block = nextBlock++) {
+                const FrontierPart& part = frontier[blocks[block].first];
+                size_t end = min(part.ids.size(), blocks[block].second + FRONTIER_BLOCK);
+                for (size_t i = blocks[block].second; i < end; i++) {
+                    const uint32_t* subsetBegin = part.pool.data() + part.offsets[i];
+                    const uint32_t* subsetEnd = part.pool.data() + part.offsets[i + 1];
+                    size_t row = partRow[blocks[block].first] + i;
+                    rowOutputs[row] = SubsetOutput(nfa, subsetBegin, subsetEnd);
+                    for (uint32_t input = 0; input < numInputs; input++) {
+                        CollectTargets(nfa, closureOffsets, closure, subsetBegin, subsetEnd, input,
+                            stamps, ++collection, collected);
+                        if (collected.empty()) {
+                            rowTargets[row * numInputs + input] = NO_SUBSET;
+                            continue;
+                        }
+                        bool isNew;
+                        uint64_t target = internShared(collected.data(), collected.data() + collected.size(), isNew);
+                        rowTargets[row * numInputs + input] = target;
+                        if (isNew) {
+                            found.pool.insert(found.pool.end(), collected.begin(), collected.end());
+                            found.offsets.push_back(found.pool.size());
+                            found.ids.push_back(target);
+                        }
+                    }
+                }
+            }
+            collections[worker] = collection;
+        });
+        rowCount += levelSize;
+        frontier = move(next);
+    }
+
+    MooreAutomata dfa;
+    vector<pmr::vector<uint32_t>> finalIds;
+    for (SubsetShard& shard : shards) {
+        finalIds.emplace_back(shard.table.Count(), NO_STATE, CurrentArena());
+    }
+    pmr::vector<uint64_t> order(CurrentArena());
+    order.reserve(rowCount);
+    order.push_back(start);
+    finalIds[start & shardMask][start >> SUBSET_SHARD_BITS] = 0;
+    for (size_t current = 0; current < order.size(); current++) {
+        uint64_t id = order[current];
+        size_t row = shards[id & shardMask].rows[id >> SUBSET_SHARD_BITS];
+        dfa.outputs.push_back(rowOutputs[row]);
+        for (uint32_t input = 0; input < numInputs; input++) {
+            uint64_t target = rowTargets[row * numInputs + input];
+            if (target == NO_SUBSET) {
+                dfa.next.push_back(NO_STATE);
+                continue;
+            }
+            uint32_t& finalId = finalIds[target & shardMask][target >> SUBSET_SHARD_BITS];
+            if (finalId == NO_STATE) {
+                finalId = static_cast<uint32_t>(order.size());
+                order.push_back(target);
+            }
+            dfa.next.push_back(finalId);
+        }
+    }
+    dfa.numStates = static_cast<uint32_t>(order.size());
+    return dfa;
+}
+
+MooreAutomata DeterminizeNfa(const Nfa& nfa, unsigned threads) {
+    if (nfa.numStates == 0) {
+        return MooreAutomata();
+    }
+    pmr::vector<uint32_t> closureOffsets(CurrentArena()), closure(CurrentArena());
+    ComputeClosures(nfa, closureOffsets, closure);
+    MooreAutomata dfa = threads > 1
+        ? DeterminizeParallel(nfa, closureOffsets, closure, threads)
+        : DeterminizeSequential(nfa, closureOffsets, closure);
+    dfa.numInputs = nfa.numInputs;
+    dfa.inputs = nfa.inputs;
+    dfa.outputSymbols = nfa.outputSymbols;
+    // Пустая отметка - такой же символ, как пустая ячейка, прочитанная ReadMoore: минимизации нужен выход у каждого состояния
+    if (find(dfa.outputs.begin(), dfa.outputs.end(), NO_SYMBOL) != dfa.outputs.end()) {
+        uint32_t emptyOutput = InternSymbol(dfa.outputSymbols, "");
+        replace(dfa.outputs.begin(), dfa.outputs.end(), NO_SYMBOL, emptyOutput);
+    }
+    GenerateSymbols(dfa.states, DFA_STATE_CH, dfa.numStates);
+    return dfa;
+}
@@ -0,0 +1,408 @@
+﻿#include "Execution.h"
+#include "MappedFile.h"
+#include "OutputBuffer.h"
+#include "StreamKernel.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <string_view>
+
+using namespace std;
+
+// Вход читается блоками такого размера, обрабатываются только завершённые строки
+const size_t RUN_BLOCK_BYTES = 1 << 20;
+const size_t NO_POSITION = SIZE_MAX;
+
+static bool IsTokenSeparator(char ch) {
+    return ch == ' ' || ch == '\t' || ch == '\r';
+}
+
+static void MapByteInputs(const SymbolTable& inputs, uint32_t* byteInputs) {
+    fill(byteInputs, byteInputs + 256, NO_SYMBOL);
+    for (uint32_t input = 0; input < SymbolCount(inputs); input++) {
+        string_view name = SymbolName(inputs, input);
+        if (name.size() == 1) {
+            byteInputs[static_cast<unsigned char>(name[0])] = input;
+        }
+    }
+}
+
+// Таблица становится узкой, если номера состояний и выходов не доходят до NARROW_NONE
+static void SetMachineTable(Machine& machine, uint32_t outputCount, bool narrow) {
+    if (!narrow || machine.numStates >= NARROW_NONE || outputCount >= NARROW_NONE) {
+        return;
+    }
+    machine.narrowSteps.resize(machine.steps.size());
+    for (size_t cell = 0; cell < machine.steps.size(); cell++) {
+        MachineStep step = machine.steps[cell];
+        machine.narrowSteps[cell] = {
+            static_cast<uint16_t>(step.next == NO_STATE ? NARROW_NONE : step.next),
+            static_cast<uint16_t>(step.output == NO_SYMBOL ? NARROW_NONE : step.output)
+        };
+    }
+    machine.steps = vector<MachineStep>();
+}
+
+Machine MachineFromMoore(const MooreAutomata& automata, bool narrow) {
+    Machine machine;
+    machine.numStates = automata.numStates;
+    machine.numInputs = automata.numInputs;
+    machine.inputs = automata.inputs;
+    machine.outputSymbols = automata.outputSymbols;
+    machine.initialOutput = automata.numStates != 0 ? automata.outputs[0] : NO_SYMBOL;
+    machine.steps.resize(automata.next.size());
+    for (size_t cell = 0; cell < automata.next.size(); cell++) {
+        uint32_t next = automata.next[cell];
+        machine.steps[cell] = { next, next == NO_STATE ? NO_SYMBOL : automata.outputs[next] };
+    }
+    SetMachineTable(machine, SymbolCount(automata.outputSymbols), narrow);
+    MapByteInputs(machine.inputs, machine.byteInputs);
+    return machine;
+}
+
+Machine MachineFromMealy(const MealyAutomata& automata, bool narrow) {
+    Machine machine;
+    machine.numStates = automata.numStates;
+    machine.numInputs = automata.numInputs;
+    machine.inputs = automata.inputs;
+    machine.outputSymbols = automata.outputSymbols;
+    machine.steps.resize(automata.next.size());
+    for (size_t cell = 0; cell < automata.next.size(); cell++) {
+        machine.steps[cell] = { automata.next[cell], automata.outputs[cell] };
+    }
+    SetMachineTable(machine, SymbolCount(automata.outputSymbols), narrow);
+    MapByteInputs(machine.inputs, machine.byteInputs);
+    return machine;
+}
+
+size_t MachineTableBytes(const Machine& machine) {
+    return machine.steps.size() * sizeof(MachineStep) + machine.narrowSteps.size() * sizeof(NarrowStep);
+}
+
+// Образец для StateOrder::Frequency: номера входов, конец строки - NO_SYMBOL (образец продолжается с начала)
+static bool ReadTrace(const SymbolTable& inputs, const MachineOptions& options, vector<uint32_t>& trace) {
+    MappedFile file(options.traceFile);
+    if (!file.IsOpen()) {
+        cerr << "Error: Could not open file " << options.traceFile << endl;
+        return false;
+    }
+    string_view text = file.Data();
+    if (options.traceBytes) {
+        uint32_t byteInputs[256];
+        MapByteInputs(inputs, byteInputs);
+        trace.reserve(text.size());
+        for (char ch : text) {
+            trace.push_back(byteInputs[static_cast<unsigned char>(ch)]);
+        }
+        return true;
+    }
+    size_t pos = 0;
+    while (pos < text.size()) {
+        if (text[pos] == '\n' || IsTokenSeparator(text[pos])) {
+            if (text[pos] == '\n') {
+                trace.push_back(NO_SYMBOL);
+            }
+            pos++;
+            continue;
+        }
+        size_t tokenBegin = pos;
+        while (pos < text.size() && text[pos] != '\n' && !IsTokenSeparator(text[pos])) {
+            pos++;
+        }
+        trace.push_back(FindSymbol(inputs, text.substr(tokenBegin, pos - tokenBegin)));
+    }
+    return true;
+}
+
+Machine LoadMachine(const string& filename, const MachineOptions& options) {
+    vector<uint32_t> trace;
+    switch (DetectAutomataFile(filename)) {
+    case AutomataFileKind::MooreCsv:
+    case AutomataFileKind::MooreBinary: {
+        MooreAutomata automata;
+        if (!LoadMoore(filename, automata)) {
+            return Machine();
+        }
+        if (options.minimize) {
+            RemoveUnreachableStatesMoore(automata);
+            MinimizeMoore(automata);
+        }
+        if (options.order == StateOrder::Frequency && !ReadTrace(automata.inputs, options, trace)) {
+            return Machine();
+        }
+        if (options.order != StateOrder::Original) {
+            RenumberStatesMoore(automata, StateOrderMoore(automata, options.order, trace));
+        }
+        return MachineFromMoore(automata, options.narrow);
+    }
+    case AutomataFileKind::MealyCsv:
+    case AutomataFileKind::MealyBinary: {
+        MealyAutomata automata;
+        if (!LoadMealy(filename, automata)) {
+            return Machine();
+        }
+        if (options.minimize) {
+            RemoveUnreachableStatesMealy(automata);
+            MinimizeMealy(automata);
+        }
+        if (options.order == StateOrder::Frequency && !ReadTrace(automata.inputs, options, trace)) {
+            return Machine();
+        }
+        if (options.order != StateOrder::Original) {
+            RenumberStatesMealy(automata, StateOrderMealy(automata, options.order, trace));
+        }
+        return MachineFromMealy(automata, options.narrow);
+    }
+    default:
+        cerr << "Error: Could not open file " << filename << endl;
+        return Machine();
+    }
+}
+
+static MachineStep ReadStep(const MachineStep& step) {
+    return step;
+}
+
+static MachineStep ReadStep(const NarrowStep& step) {
+    return { step.next == NARROW_NONE ? NO_STATE : step.next, step.output == NARROW_NONE ? NO_SYMBOL : step.output };
+}
+
+template <class Step>
+static size_t RunStreamIn(const Step* steps, size_t inputs, const uint32_t* symbols, size_t length, uint32_t* outputs, uint32_t& state) {
+    uint32_t current = state;
+    size_t pos = 0;
+    for (; pos < length; pos++) {
+        uint32_t symbol = symbols[pos];
+        if (symbol >= inputs) {
+            break;
+        }
+        MachineStep step = ReadStep(steps[current * inputs + symbol]);
+        if (step.next == NO_STATE) {
+            break;
+        }
+        outputs[pos] = step.output;
+        current = step.next;
+    }
+    state = current;
+    return pos;
+}
+
+size_t RunStream(const Machine& machine, const uint32_t* symbols, size_t length, uint32_t* outputs, uint32_t& state) {
+    return machine.narrowSteps.empty()
+        ? RunStreamIn(machine.steps.data(), machine.numInputs, symbols, length, outputs, state)
+        : RunStreamIn(machine.narrowSteps.data(), machine.numInputs, symbols, length, outputs, state);
+}
+
+template <class Step>
+static void RunStreamsIn(const Machine& machine, const Step* steps, const uint32_t* symbols, uint32_t* outputs, vector<StreamSpan>& streams) {
+    size_t inputs = machine.numInputs;
+    // Дорожка ведёт один поток; активные дорожки занимают [0, active)
+    struct Lane {
+        size_t stream;
+        size_t pos;
+        size_t end;
+        uint32_t state;
+        uint32_t output;
+    };
+    Lane lanes[MACHINE_LANES];
+    size_t nextStream = 0;
+    auto start = [&](Lane& lane) {
+        while (nextStream < streams.size()) {
+            StreamSpan& span = streams[nextStream];
+            span.done = 0;
+            span.state = 0;
+            span.output = machine.initialOutput;
+            if (span.length != 0 && machine.numStates != 0) {
+                lane = { nextStream++, span.begin, span.begin + span.length, 0, machine.initialOutput };
+                return true;
+            }
+            nextStream++;
+        }
+        return false;
+    };
+    size_t active = 0;
+    while (active < MACHINE_LANES && start(lanes[active])) {
+        active++;
+    }
+    while (active > 0) {
+        for (size_t i = 0; i < active;) {
+            Lane& lane = lanes[i];
+            uint32_t symbol = symbols[lane.pos];
+            MachineStep step = symbol < inputs ? ReadStep(steps[lane.state * inputs + symbol]) : MachineStep{ NO_STATE, NO_SYMBOL };
+            bool stopped = step.next == NO_STATE;
+            if (!stopped) {
+                outputs[lane.pos] = step.output;
+                lane.state = step.next;
+                lane.output = step.output;
+                lane.pos++;
+            }
+            if (stopped || lane.pos == lane.end) {
+                StreamSpan& span = streams[lane.stream];
+                span.done = lane.pos - span.begin;
+                span.state = lane.state;
+                span.output = lane.output;
+                if (!start(lane)) {
+                    lane = lanes[--active];
+                    continue;
+                }
+            }
+            i++;
+        }
+    }
+}
+
+void RunStreams(const Machine& machine, const uint32_t* symbols, uint32_t* outputs, vector<StreamSpan>& streams) {
+    if (machine.narrowSteps.empty()) {
+        RunStreamsIn(machine, machine.steps.data(), symbols, outputs, streams);
+    }
+    else {
+        RunStreamsIn(machine, machine.narrowSteps.data(), symbols, outputs, streams);
+    }
+}
+
+// Рабочие массивы прогона строк, переиспользуются между блоками
+struct RunBuffers {
+    vector<uint32_t> symbols;
+    vector<uint32_t> outputs;
+    vector<StreamSpan> streams;
+    // номер символа с неизвестным именем в потоке, length - нет такого
+    vector<size_t> unknownAt;
+};
+
+static void AppendOutput(const Machine& machine, uint32_t output, OutputBuffer& target) {
+    target.Append(output == NO_SYMBOL ? string_view(BLANK_OUTPUT_CH) : SymbolName(machine.outputSymbols, output));
+}
+
+// Прогоняет блок завершённых строк, firstLine - номер первой строки блока для сообщений
+static bool RunLines(const Machine& machine, string_view text, size_t firstLine, RunBuffers& buffers, OutputBuffer& output) {
+    buffers.symbols.clear();
+    buffers.streams.clear();
+    buffers.unknownAt.clear();
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t lineEnd = text.find('\n', pos);
+        if (lineEnd == string_view::npos) {
+            lineEnd = text.size();
+        }
+        StreamSpan span;
+        span.begin = buffers.symbols.size();
+        size_t unknown = NO_POSITION;
+        while (pos < lineEnd) {
+            while (pos < lineEnd && IsTokenSeparator(text[pos])) {
+                pos++;
+            }
+            size_t tokenBegin = pos;
+            while (pos < lineEnd && !IsTokenSeparator(text[pos])) {
+                pos++;
+            }
+            if (tokenBegin == pos) {
+                continue;
+            }
+            string_view token = text.substr(tokenBegin, pos - tokenBegin);
+            uint32_t symbol = FindSymbol(machine.inputs, token);
+            if (symbol == NO_SYMBOL && unknown == NO_POSITION) {
+                unknown = buffers.symbols.size() - span.begin;
+                cerr << "Error: line " << firstLine + buffers.streams.size() << ", symbol " << unknown + 1
+                    << ": unknown input " << token << endl;
+            }
+            buffers.symbols.push_back(symbol);
+        }
+        span.length = buffers.symbols.size() - span.begin;
+        buffers.streams.push_back(span);
+        buffers.unknownAt.push_back(unknown == NO_POSITION ? span.length : unknown);
+        pos = lineEnd + 1;
+    }
+    buffers.outputs.resize(buffers.symbols.size());
+    if (DefaultStreamKernel() == StreamKernel::Avx2 && MachineTableBytes(machine) <= LOCKSTEP_TABLE_BYTES) {
+        SimulateStreams(machine, buffers.symbols.data(), buffers.outputs.data(), buffers.streams, StreamKernel::Avx2);
+    }
+    else {
+        RunStreams(machine, buffers.symbols.data(), buffers.outputs.data(), buffers.streams);
+    }
+
+    bool ok = true;
+    for (size_t i = 0; i < buffers.streams.size(); i++) {
+        const StreamSpan& span = buffers.streams[i];
+        for (size_t j = 0; j < span.done; j++) {
+            if (j != 0) {
+                output.Append(' ');
+            }
+            AppendOutput(machine, buffers.outputs[span.begin + j], output);
+        }
+        output.Append('\n');
+        if (span.done < span.length) {
+            ok = false;
+            if (span.done != buffers.unknownAt[i]) {
+                cerr << "Error: line " << firstLine + i << ", symbol " << span.done + 1 << ": no transition" << endl;
+            }
+        }
+    }
+    return ok;
+}
+
+static bool RunTokenLines(const Machine& machine, FILE* input, OutputBuffer& output) {
+    RunBuffers buffers;
+    string pending;
+    size_t lineNumber = 1;
+    bool ok = true;
+    bool eof = false;
+    while (!eof) {
+        size_t used = pending.size();
+        pending.resize(used + RUN_BLOCK_BYTES);
+        size_t read = fread(pending.data() + used, 1, RUN_BLOCK_BYTES, input);
+        pending.resize(used + read);
+        eof = read < RUN_BLOCK_BYTES;
+        // Незавершённая строка ждёт следующего блока, в конце входа обрабатывается как есть
+        size_t lastNewline = pending.rfind('\n');
+        size_t ready = eof ? pending.size() : (lastNewline == string::npos ? 0 : lastNewline + 1);
+        if (ready == 0) {
+            continue;
+        }
+        string_view text(pending.data(), ready);
+        ok = RunLines(machine, text, lineNumber, buffers, output) && ok;
+        lineNumber += buffers.streams.size();
+        pending.erase(0, ready);
+        output.Flush();
+    }
+    return ok;
+}
+
+static bool RunByteStream(const Machine& machine, FILE* input, OutputBuffer& output) {
+    vector<char> block(RUN_BLOCK_BYTES);
+    vector<uint32_t> symbols(RUN_BLOCK_BYTES), outputs(RUN_BLOCK_BYTES);
+    uint32_t state = 0;
+    size_t position = 0;
+    bool ok = machine.numStates != 0;
+    bool first = true;
+    while (ok) {
+        size_t read = fread(block.data(), 1, block.size(), input);
+        if (read == 0) {
+            break;
+        }
+        for (size_t i = 0; i < read; i++) {
+            symbols[i] = machine.byteInputs[static_cast<unsigned char>(block[i])];
+        }
+        size_t done = RunStream(machine, symbols.data(), read, outputs.data(), state);
+        for (size_t i = 0; i < done; i++) {
+            if (!first) {
+                output.Append(' ');
+            }
+            first = false;
+            AppendOutput(machine, outputs[i], output);
+        }
+        if (done < read) {
+            ok = false;
+            cerr << "Error: byte " << position + done + 1 << ": "
+                << (symbols[done] == NO_SYMBOL ? "unknown input" : "no transition") << endl;
+        }
+        position += read;
+        output.Flush();
+    }
+    output.Append('\n');
+    return ok;
+}
+
+bool RunMachine(const Machine& machine, FILE* input, OutputBuffer& output, const RunOptions& options) {
+    return options.bytes ? RunByteStream(machine, input, output) : RunTokenLines(machine, input, output);
+}
@@ -0,0 +1,90 @@
+﻿#pragma once
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "AutomataCore.h"
+
+class OutputBuffer;
+
+// Исполнение автоматов: прогон потоков входных символов с начального состояния (первого столбца).
+// Переход и выход на нём лежат в одной ячейке, поэтому шаг читает одну строку кэша.
+// Автомат Мура на каждом символе выдаёт выход состояния, в которое перешёл, как после ConvertMooreToMealy
+struct MachineStep {
+    uint32_t next;
+    uint32_t output;
+};
+
+// Узкая ячейка для автоматов до 65535 состояний и выходов: таблица вдвое меньше.
+// NARROW_NONE - пустой переход или выход, при чтении становится NO_STATE / NO_SYMBOL
+struct NarrowStep {
+    uint16_t next;
+    uint16_t output;
+};
+const uint16_t NARROW_NONE = UINT16_MAX;
+
+struct Machine {
+    uint32_t numStates = 0;
+    uint32_t numInputs = 0;
+    // steps[state * numInputs + input]; next == NO_STATE - перехода нет.
+    // Для узкой таблицы заполнен narrowSteps с той же раскладкой, а steps пуст
+    std::vector<MachineStep> steps;
+    std::vector<NarrowStep> narrowSteps;
+    SymbolTable inputs;
+    SymbolTable outputSymbols;
+    // Выход начального состояния Мура - итог пустого потока; у автомата Мили NO_SYMBOL
+    uint32_t initialOutput = NO_SYMBOL;
+    // Номер входа для байта (входы с именем из одного символа), NO_SYMBOL - такого входа нет
+    uint32_t byteInputs[256];
+};
+
+// narrow - узкие ячейки, если состояния и выходы помещаются в 16 бит
+Machine MachineFromMoore(const MooreAutomata& automata, bool narrow = true);
+Machine MachineFromMealy(const MealyAutomata& automata, bool narrow = true);
+size_t MachineTableBytes(const Machine& machine);
+
+// Подготовка таблицы при загрузке: меньшая таблица и соседство горячих состояний лучше ложатся в кэш,
+// выходы на любых потоках те же
+struct MachineOptions {
+    // удалить недостижимые состояния и минимизировать
+    bool minimize = false;
+    // перенумерация после минимизации; Frequency - по образцу traceFile в формате входа run
+    StateOrder order = StateOrder::Original;
+    std::string traceFile;
+    bool traceBytes = false;
+    bool narrow = true;
+};
+
+// CSV или бинарный файл любого типа; пустой автомат, если файл не прочитан
+Machine LoadMachine(const std::string& filename, const MachineOptions& options = MachineOptions());
+
+// Прогоняет поток с состояния state: outputs[i] - выход на i-м символе, state - состояние после потока.
+// Возвращает число пройденных символов: меньше length, если перехода нет или символ не из алфавита
+size_t RunStream(const Machine& machine, const uint32_t* symbols, size_t length, uint32_t* outputs, uint32_t& state);
+
+// Независимый поток внутри общего массива символов
+struct StreamSpan {
+    size_t begin = 0;
+    size_t length = 0;
+    // заполняются RunStreams
+    size_t done = 0;
+    uint32_t state = 0;
+    // выход последнего перехода, у пустого потока - Machine::initialOutput
+    uint32_t output = NO_SYMBOL;
+};
+
+// Потоки по MACHINE_LANES штук идут вперемешку: переходы соседних потоков не зависят друг от друга,
+// и промахи кэша по таблице перекрываются. Закончившийся поток сменяется следующим
+const size_t MACHINE_LANES = 8;
+void RunStreams(const Machine& machine, const uint32_t* symbols, uint32_t* outputs, std::vector<StreamSpan>& streams);
+
+// Режим run: каждая строка входа - независимый поток имён входов через пробелы,
+// на выходе - строка имён выходов. bytes - весь вход один поток, каждый байт - вход.
+// Вход читается блоками, поэтому годится и бесконечный поток из stdin
+struct RunOptions {
+    bool bytes = false;
+};
+
+// false, если хотя бы один поток остановился на неизвестном символе или пустом переходе
+bool RunMachine(const Machine& machine, FILE* input, OutputBuffer& output, const RunOptions& options);
@@ -0,0 +1,332 @@
+﻿#include "Grammar.h"
+#include "MappedFile.h"
+#include "OutputBuffer.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+const std::string FINAL_STATE_CH = "F";
+const std::string EMPTY_STATE_CH = "H";
+const std::string UTF8_BOM = "\xEF\xBB\xBF";
+
+using namespace std;
+
+enum class GrammarTokenKind {
+    Nonterminal,
+    Terminal,
+    Arrow,
+    Bar,
+    End
+};
+
+// text - имя нетерминала без скобок или символ терминала, указывает в исходный текст
+struct GrammarToken {
+    GrammarTokenKind kind = GrammarTokenKind::End;
+    string_view text;
+    size_t line = 1;
+    size_t column = 1;
+};
+
+// Столбец считается в символах Юникода, а не в байтах
+struct GrammarLexer {
+    string_view text;
+    size_t pos = 0;
+    size_t line = 1;
+    size_t column = 1;
+};
+
+[[noreturn]] static void ThrowGrammarError(size_t line, size_t column, const string& message) {
+    throw runtime_error("line " + to_string(line) + ", column " + to_string(column) + ": " + message);
+}
+
+static bool IsNameChar(char ch) {
+    return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9') || ch == '_';
+}
+
+static bool IsGrammarSpace(char ch) {
+    return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n' || ch == '\v' || ch == '\f';
+}
+
+// Сдвиг на один символ из length байт
+static void Advance(GrammarLexer& lexer, size_t length = 1) {
+    if (lexer.text[lexer.pos] == '\n') {
+        lexer.line++;
+        lexer.column = 1;
+    }
+    else {
+        lexer.column++;
+    }
+    lexer.pos += length;
+}
+
+static GrammarToken NextGrammarToken(GrammarLexer& lexer) {
+    while (lexer.pos < lexer.text.size() && IsGrammarSpace(lexer.text[lexer.pos])) {
+        Advance(lexer);
+    }
+    GrammarToken token;
+    token.line = lexer.line;
+    token.column = lexer.column;
+    if (lexer.pos == lexer.text.size()) {
+        return token;
+    }
+    char ch = lexer.text[lexer.pos];
+    if (ch == '<') {
+        Advance(lexer);
+        size_t begin = lexer.pos;
+        while (lexer.pos < lexer.text.size() && IsNameChar(lexer.text[lexer.pos])) {
+            Advance(lexer);
+        }
+        if (lexer.pos == begin) {
+            ThrowGrammarError(lexer.line, lexer.column, "expected nonterminal name after '<'");
+        }
+        if (lexer.pos == lexer.text.size() || lexer.text[lexer.pos] != '>') {
+            ThrowGrammarError(lexer.line, lexer.column, "expected '>'");
+        }
+        token.kind = GrammarTokenKind::Nonterminal;
+        token.text = lexer.text.substr(begin, lexer.pos - begin);
+        Advance(lexer);
+    }
+    else if (ch == '-') {
+        Advance(lexer);
+        if (lexer.pos == lexer.text.size() || lexer.text[lexer.pos] != '>') {
+            ThrowGrammarError(token.line, token.column, "expected '->'");
+        }
+        token.kind = GrammarTokenKind::Arrow;
+        Advance(lexer);
+    }
+    else if (ch == '|') {
+        token.kind = GrammarTokenKind::Bar;
+        Advance(lexer);
+    }
+    else if (IsNameChar(ch) || static_cast<unsigned char>(ch) >= 0x80) {
+        // Терминал - один символ: буква, цифра, '_' или любой символ вне ASCII (в том числе ε)
+        size_t length = Utf8Length(lexer.text, lexer.pos);
+        if (length == 0) {
+            ThrowGrammarError(token.line, token.column, "invalid UTF-8");
+        }
+        token.kind = GrammarTokenKind::Terminal;
+        token.text = lexer.text.substr(lexer.pos, length);
+        Advance(lexer, length);
+    }
+    else {
+        ThrowGrammarError(token.line, token.column, string("unexpected character '") + ch + "'");
+    }
+    return token;
+}
+
+// Альтернатива правила state -> ...: терминал и, возможно, нетерминал слева (левая грамматика)
+// или справа (правая); без нетерминала - NO_SYMBOL
+struct GrammarAlternative {
+    uint32_t state;
+    uint32_t symbol;
+    uint32_t nonterminal;
+};
+
+enum class GrammarSide {
+    Unknown,
+    Left,
+    Right
+};
+
+// Разбор спуском с просмотром на две лексемы вперёд: "<A> ->" начинает новое правило,
+// поэтому правила можно переносить на следующие строки где угодно.
+// Вид грамматики определяется первой альтернативой с нетерминалом, альтернатива другого вида - ошибка.
+// Имена сразу заменяются номерами в nonterminals и terminals
+struct GrammarParser {
+    GrammarLexer lexer;
+    GrammarToken current;
+    GrammarToken lookahead;
+    GrammarSide side = GrammarSide::Unknown;
+    SymbolTable nonterminals;
+    SymbolTable terminals;
+    // номера нетерминалов в левых частях правил, по порядку правил
+    vector<uint32_t> ruleStates;
+    vector<GrammarAlternative> alternatives;
+};
+
+static void NextToken(GrammarParser& parser) {
+    parser.current = parser.lookahead;
+    parser.lookahead = NextGrammarToken(parser.lexer);
+}
+
+static bool AtRuleStart(const GrammarParser& parser) {
+    return parser.current.kind == GrammarTokenKind::Nonterminal && parser.lookahead.kind == GrammarTokenKind::Arrow;
+}
+
+static void SetGrammarSide(GrammarParser& parser, GrammarSide side, const GrammarToken& token) {
+    if (parser.side == GrammarSide::Unknown) {
+        parser.side = side;
+    }
+    else if (parser.side != side) {
+        ThrowGrammarError(token.line, token.column, side == GrammarSide::Left
+            ? "left-linear alternative in a right-linear grammar"
+            : "right-linear alternative in a left-linear grammar");
+    }
+}
+
+static uint32_t ExpectTerminal(GrammarParser& parser) {
+    if (parser.current.kind != GrammarTokenKind::Terminal) {
+        ThrowGrammarError(parser.current.line, parser.current.column, "expected terminal");
+    }
+    uint32_t symbol = InternSymbol(parser.terminals, parser.current.text);
+    NextToken(parser);
+    return symbol;
+}
+
+static uint32_t TakeNonterminal(GrammarParser& parser) {
+    uint32_t nonterminal = InternSymbol(parser.nonterminals, parser.current.text);
+    NextToken(parser);
+    return nonterminal;
+}
+
+static void ParseAlternative(GrammarParser& parser, uint32_t state) {
+    GrammarAlternative alternative{ state, NO_SYMBOL, NO_SYMBOL };
+    if (parser.current.kind == GrammarTokenKind::Nonterminal && !AtRuleStart(parser)) {
+        SetGrammarSide(parser, GrammarSide::Left, parser.current);
+        alternative.nonterminal = TakeNonterminal(parser);
+        alternative.symbol = ExpectTerminal(parser);
+    }
+    else {
+        alternative.symbol = ExpectTerminal(parser);
+        if (parser.current.kind == GrammarTokenKind::Nonterminal && !AtRuleStart(parser)) {
+            SetGrammarSide(parser, GrammarSide::Right, parser.current);
+            alternative.nonterminal = TakeNonterminal(parser);
+        }
+    }
+    parser.alternatives.push_back(alternative);
+}
+
+static void ParseRule(GrammarParser& parser) {
+    if (parser.current.kind != GrammarTokenKind::Nonterminal) {
+        ThrowGrammarError(parser.current.line, parser.current.column, "expected rule '<nonterminal> ->'");
+    }
+    uint32_t state = TakeNonterminal(parser);
+    if (parser.current.kind != GrammarTokenKind::Arrow) {
+        ThrowGrammarError(parser.current.line, parser.current.column, "expected '->'");
+    }
+    NextToken(parser);
+    parser.ruleStates.push_back(state);
+    ParseAlternative(parser, state);
+    while (parser.current.kind == GrammarTokenKind::Bar) {
+        NextToken(parser);
+        ParseAlternative(parser, state);
+    }
+    if (parser.current.kind != GrammarTokenKind::End && !AtRuleStart(parser)) {
+        ThrowGrammarError(parser.current.line, parser.current.column, "expected '|' or next rule");
+    }
+}
+
+// Номера имён table по возрастанию имени; first (если есть) ставится первым
+static vector<uint32_t> SortedSymbols(const SymbolTable& table, const vector<bool>& used, uint32_t first = NO_SYMBOL) {
+    vector<uint32_t> order;
+    for (uint32_t id = 0; id < used.size(); id++) {
+        if (used[id] && id != first) {
+            order.push_back(id);
+        }
+    }
+    sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return SymbolName(table, a) < SymbolName(table, b);
+    });
+    if (first != NO_SYMBOL) {
+        order.insert(order.begin(), first);
+    }
+    return order;
+}
+
+// Правая грамматика: A -> a B - переход A по a в B, A -> a - в конечное состояние F, начальное - первое правило.
+// Состояния - нетерминалы с правилами и F; правила самого F и переходы в нетерминалы без правил отбрасываются.
+// Левая: A -> B a - переход B по a в A, A -> a - из начального состояния H, конечное - первое правило,
+// состояния - все нетерминалы и H. Грамматика без нетерминалов в правых частях считается левой
+static void BuildGrammar(GrammarParser& parser, Grammar& grammar) {
+    Nfa& nfa = grammar.nfa;
+    grammar.isLeftType = parser.side != GrammarSide::Right;
+    uint32_t extra = InternSymbol(parser.nonterminals, grammar.isLeftType ? EMPTY_STATE_CH : FINAL_STATE_CH);
+    uint32_t numNonterminals = SymbolCount(parser.nonterminals);
+    vector<bool> isState(numNonterminals, grammar.isLeftType);
+    for (uint32_t state : parser.ruleStates) {
+        isState[state] = true;
+    }
+    isState[extra] = true;
+    uint32_t initial = grammar.isLeftType ? extra : parser.ruleStates.front();
+    vector<uint32_t> stateIndex(numNonterminals, NO_STATE);
+    for (uint32_t id : SortedSymbols(parser.nonterminals, isState, initial)) {
+        stateIndex[id] = nfa.numStates++;
+    }
+    GenerateSymbols(nfa.states, NFA_STATE_CH, nfa.numStates);
+    nfa.outputs.assign(nfa.numStates, NO_SYMBOL);
+    if (!parser.ruleStates.empty()) {
+        nfa.outputs[stateIndex[grammar.isLeftType ? parser.ruleStates.front() : extra]] = InternSymbol(nfa.outputSymbols, FINAL_MARK);
+    }
+
+    vector<bool> usedSymbol(SymbolCount(parser.terminals), false);
+    for (const GrammarAlternative& alternative : parser.alternatives) {
+        if (grammar.isLeftType || alternative.state != extra) {
+            usedSymbol[alternative.symbol] = true;
+        }
+    }
+    vector<uint32_t> inputIndex(usedSymbol.size(), NO_SYMBOL);
+    for (uint32_t id : SortedSymbols(parser.terminals, usedSymbol)) {
+        string_view symbol = SymbolName(parser.terminals, id);
+        if (symbol != EPSILON_SYMBOL) {
+            inputIndex[id] = AddSymbol(nfa.inputs, symbol);
+        }
+    }
+    nfa.numInputs = SymbolCount(nfa.inputs);
+
+    vector<NfaEdge> edges;
+    edges.reserve(parser.alternatives.size());
+    for (const GrammarAlternative& alternative : parser.alternatives) {
+        uint32_t other = alternative.nonterminal == NO_SYMBOL ? extra : alternative.nonterminal;
+        uint32_t input = inputIndex[alternative.symbol];
+        if (grammar.isLeftType) {
+            edges.push_back({ stateIndex[other], input, stateIndex[alternative.state] });
+        }
+        else if (alternative.state != extra && stateIndex[other] != NO_STATE) {
+            edges.push_back({ stateIndex[alternative.state], input, stateIndex[other] });
+        }
+    }
+    SetNfaTransitions(nfa, edges);
+}
+
+Grammar ParseGrammar(string_view text) {
+    if (text.substr(0, UTF8_BOM.size()) == UTF8_BOM) {
+        text.remove_prefix(UTF8_BOM.size());
+    }
+    GrammarParser parser;
+    parser.lexer.text = text;
+    parser.lookahead = NextGrammarToken(parser.lexer);
+    NextToken(parser);
+    while (parser.current.kind != GrammarTokenKind::End) {
+        ParseRule(parser);
+    }
+    Grammar grammar;
+    BuildGrammar(parser, grammar);
+    return grammar;
+}
+
+Grammar ReadGrammar(const string& filename) {
+    MappedFile file(filename);
+    if (!file.IsOpen()) {
+        throw runtime_error("Unable to open file " + filename);
+    }
+    return ParseGrammar(file.Data());
+}
+
+string GrammarToCsv(const Grammar& grammar) {
+    string text;
+    OutputBuffer writer(text);
+    WriteNfaCsv(grammar.nfa, writer);
+    writer.Close();
+    return text;
+}
+
+void ExportToFile(const Grammar& grammar, const string& outputFileName) {
+    OutputBuffer writer(outputFileName);
+    if (!writer.IsOpen()) {
+        throw runtime_error("Could not open file for writing.");
+    }
+    WriteNfaCsv(grammar.nfa, writer);
+    if (!writer.Close()) {
+        throw runtime_error("Could not write file.");
+    }
+}
@@ -0,0 +1,25 @@
+﻿#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "AutomataCore.h"
+#include "Nfa.h"
+
+// Регулярная грамматика (левая или правая), скомпилированная в НКА для лабораторной 3.
+// Состояния q0, q1, ... - нетерминалы и служебное F (правая) или H (левая грамматика): начальное - q0,
+// остальные по возрастанию имени нетерминала. Входы - терминалы по возрастанию байтов UTF-8,
+// терминал ε - пустой переход. Конечное состояние отмечено выходом F.
+// nfa можно сразу передать в DeterminizeNfa, не записывая таблицу
+struct Grammar {
+    bool isLeftType = false;
+    Nfa nfa;
+};
+
+// Текст в UTF-8; вид грамматики определяется по правилам за тот же проход.
+// Ошибки - исключения std::runtime_error с номером строки и столбца
+Grammar ParseGrammar(std::string_view text);
+Grammar ReadGrammar(const std::string& filename);
+
+std::string GrammarToCsv(const Grammar& grammar);
+void ExportToFile(const Grammar& grammar, const std::string& outputFileName);
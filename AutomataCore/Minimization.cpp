@@ -0,0 +1,552 @@
+﻿#include "AutomataCore.h"
+#include "Parallel.h"
+#include "SignatureKernel.h"
+
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+
+using namespace std;
+
+const string CLASS_CH = "X";
+const bool NEED_INITIALIZATION = true;
+const bool NOT_NEED_INITIALIZATION = false;
+
+static uint32_t ClassOf(const pmr::vector<uint32_t>& classTable, uint32_t state) {
+    return state == NO_STATE ? NO_STATE : classTable[state];
+}
+
+static void LookForSameState(const MealyAutomata& aut, uint32_t stateToCheck, const pmr::vector<uint32_t>& classTable, pmr::vector<uint32_t>& newClassTable, uint32_t& classNum) {
+    size_t inputs = aut.numInputs;
+    bool same = false;
+    for (uint32_t state = 0; state < stateToCheck; state++) {
+        same = classTable[stateToCheck] == classTable[state];
+        for (size_t input = 0; input < inputs && same; input++) {
+            if (ClassOf(classTable, aut.next[stateToCheck * inputs + input]) != ClassOf(classTable, aut.next[state * inputs + input])) {
+                same = false;
+            }
+        }
+        if (same) {
+            newClassTable[stateToCheck] = newClassTable[state];
+            break;
+        }
+    }
+    if (!same) {
+        newClassTable[stateToCheck] = classNum++;
+    }
+}
+
+static void LookForSameOutputs(const MealyAutomata& aut, uint32_t stateToCheck, pmr::vector<uint32_t>& classTable, uint32_t& classNum) {
+    size_t inputs = aut.numInputs;
+    bool same = false;
+    for (uint32_t state = 0; state < stateToCheck; state++) {
+        same = true;
+        for (size_t input = 0; input < inputs; input++) {
+            if (aut.outputs[stateToCheck * inputs + input] != aut.outputs[state * inputs + input]) {
+                same = false;
+                break;
+            }
+        }
+        if (same) {
+            classTable[stateToCheck] = classTable[state];
+            break;
+        }
+    }
+    if (!same) {
+        classTable[stateToCheck] = classNum++;
+    }
+}
+
+// Возвращает количество классов
+static uint32_t GetClassTable(const MealyAutomata& aut, pmr::vector<uint32_t>& classTable, const pmr::vector<uint32_t>& currClassTable, bool needInitialization) {
+    classTable.assign(aut.numStates, 0);
+    uint32_t classNum = 1;
+    for (uint32_t state = 1; state < aut.numStates; state++) {
+        if (needInitialization) {
+            LookForSameOutputs(aut, state, classTable, classNum);
+        }
+        else {
+            LookForSameState(aut, state, currClassTable, classTable, classNum);
+        }
+    }
+    return classNum;
+}
+
+// Классы пронумерованы в порядке первой встречи, поэтому строка класса c
+// берётся из состояния с номером не меньше c и таблица сжимается на месте
+static void CollapseClassesMealy(MealyAutomata& aut, const pmr::vector<uint32_t>& classTable, uint32_t classCount) {
+    pmr::vector<bool> addedClasses(classCount, false, CurrentArena());
+    uint32_t addedCount = 0;
+    size_t inputs = aut.numInputs;
+    for (uint32_t state = 0; state < aut.numStates && addedCount < classCount; state++) {
+        uint32_t stateClass = classTable[state];
+        if (addedClasses[stateClass]) {
+            continue;
+        }
+        addedClasses[stateClass] = true;
+        addedCount++;
+        for (size_t input = 0; input < inputs; input++) {
+            aut.next[stateClass * inputs + input] = ClassOf(classTable, aut.next[state * inputs + input]);
+            aut.outputs[stateClass * inputs + input] = aut.outputs[state * inputs + input];
+        }
+    }
+    aut.numStates = classCount;
+    aut.next.resize(size_t(classCount) * inputs);
+    aut.outputs.resize(size_t(classCount) * inputs);
+    aut.states = SymbolTable();
+    GenerateSymbols(aut.states, CLASS_CH, classCount);
+}
+
+static void MinimizeMealyLegacy(MealyAutomata& automata) {
+    pmr::vector<uint32_t> classTable(CurrentArena());
+    uint32_t classCount = GetClassTable(automata, classTable, classTable, NEED_INITIALIZATION);
+    bool canBeMinimized = automata.numStates > 0;
+    while (canBeMinimized) {
+        pmr::vector<uint32_t> currClassTable(CurrentArena());
+        uint32_t currClassCount = GetClassTable(automata, currClassTable, classTable, NOT_NEED_INITIALIZATION);
+        canBeMinimized = currClassCount != classCount;
+        classTable = move(currClassTable);
+        classCount = currClassCount;
+    }
+    CollapseClassesMealy(automata, classTable, automata.numStates > 0 ? classCount : 0);
+}
+
+static uint32_t InitilizeClassTable(const MooreAutomata& aut, pmr::vector<uint32_t>& classTable) {
+    classTable.assign(aut.numStates, 0);
+    pmr::vector<uint32_t> outputWithClass(SymbolCount(aut.outputSymbols), NO_STATE, CurrentArena());
+    uint32_t classNum = 0;
+    for (uint32_t state = 0; state < aut.numStates; state++) {
+        uint32_t output = aut.outputs[state];
+        if (outputWithClass[output] == NO_STATE) {
+            outputWithClass[output] = classNum++;
+        }
+        classTable[state] = outputWithClass[output];
+    }
+    return classNum;
+}
+
+static uint32_t GetClassTableForMoore(const MooreAutomata& aut, const pmr::vector<uint32_t>& currClassTable, pmr::vector<uint32_t>& classTable) {
+    classTable.assign(aut.numStates, 0);
+    map<vector<uint32_t>, uint32_t> pastTransWithClass;
+    uint32_t classNum = 0;
+    size_t inputs = aut.numInputs;
+    vector<uint32_t> transitionsInState(inputs + 1);
+    for (uint32_t state = 0; state < aut.numStates; state++) {
+        for (size_t input = 0; input < inputs; input++) {
+            transitionsInState[input] = ClassOf(currClassTable, aut.next[state * inputs + input]);
+        }
+        transitionsInState[inputs] = currClassTable[state];
+        auto [it, inserted] = pastTransWithClass.emplace(transitionsInState, classNum);
+        if (inserted) {
+            classNum++;
+        }
+        classTable[state] = it->second;
+    }
+    return classNum;
+}
+
+static void CollapseClassesMoore(MooreAutomata& aut, const pmr::vector<uint32_t>& classTable, uint32_t classCount) {
+    pmr::vector<bool> addedClasses(classCount, false, CurrentArena());
+    uint32_t addedCount = 0;
+    size_t inputs = aut.numInputs;
+    for (uint32_t state = 0; state < aut.numStates && addedCount < classCount; state++) {
+        uint32_t stateClass = classTable[state];
+        if (addedClasses[stateClass]) {
+            continue;
+        }
+        addedClasses[stateClass] = true;
+        addedCount++;
+        aut.outputs[stateClass] = aut.outputs[state];
+        for (size_t input = 0; input < inputs; input++) {
+            aut.next[stateClass * inputs + input] = ClassOf(classTable, aut.next[state * inputs + input]);
+        }
+    }
+    aut.numStates = classCount;
+    aut.next.resize(size_t(classCount) * inputs);
+    aut.outputs.resize(classCount);
+    aut.states = SymbolTable();
+    GenerateSymbols(aut.states, CLASS_CH, classCount);
+}
+
+static void MinimizeMooreLegacy(MooreAutomata& automata) {
+    pmr::vector<uint32_t> classTable(CurrentArena());
+    uint32_t classCount = InitilizeClassTable(automata, classTable);
+    bool canBeMinimized = true;
+    while (canBeMinimized) {
+        pmr::vector<uint32_t> currClassTable(CurrentArena());
+        uint32_t currClassCount = GetClassTableForMoore(automata, classTable, currClassTable);
+        if (currClassCount == classCount) {
+            canBeMinimized = false;
+        }
+        else
+        {
+            classCount = currClassCount;
+            classTable = move(currClassTable);
+        }
+    }
+    CollapseClassesMoore(automata, classTable, classCount);
+}
+
+static uint64_t HashRow(const uint32_t* row, size_t width) {
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (size_t i = 0; i < width; i++) {
+        hash = (hash ^ row[i]) * 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+// Начальное разбиение для Мили: состояния с одинаковыми строками выходов попадают в один класс
+static uint32_t GroupOutputRows(const MealyAutomata& aut, pmr::vector<uint32_t>& classTable) {
+    classTable.assign(aut.numStates, 0);
+    // хеш строки -> первые состояния классов с таким хешем
+    pmr::unordered_map<uint64_t, pmr::vector<uint32_t>> representatives(CurrentArena());
+    uint32_t classNum = 0;
+    size_t inputs = aut.numInputs;
+    const uint32_t* outputs = aut.outputs.data();
+    for (uint32_t state = 0; state < aut.numStates; state++) {
+        const uint32_t* row = outputs + state * inputs;
+        pmr::vector<uint32_t>& candidates = representatives[HashRow(row, inputs)];
+        uint32_t found = NO_STATE;
+        for (uint32_t candidate : candidates) {
+            if (equal(row, row + inputs, outputs + candidate * inputs)) {
+                found = classTable[candidate];
+                break;
+            }
+        }
+        if (found == NO_STATE) {
+            found = classNum++;
+            candidates.push_back(state);
+        }
+        classTable[state] = found;
+    }
+    return classNum;
+}
+
+// Алгоритм Хопкрофта: уточняет начальное разбиение initialClass до разбиения на классы эквивалентности.
+// Классы в classTable пронумерованы в порядке первой встречи, как в GetClassTableForMoore
+static uint32_t RefinePartition(const pmr::vector<uint32_t>& next, uint32_t numStates, uint32_t numInputs,
+    const pmr::vector<uint32_t>& initialClass, uint32_t initialCount, pmr::vector<uint32_t>& classTable)
+{
+    size_t inputs = numInputs;
+    // Пустые переходы ведут в фиктивный сток, который не эквивалентен ни одному состоянию
+    bool hasSink = find(next.begin(), next.end(), NO_STATE) != next.end();
+    uint32_t sink = numStates;
+    uint32_t total = numStates + (hasSink ? 1 : 0);
+    auto successor = [&](uint32_t state, size_t input) {
+        uint32_t nextState = state == sink ? sink : next[state * inputs + input];
+        return nextState == NO_STATE ? sink : nextState;
+    };
+
+    // Рабочие массивы разбиения - обычные vector, не из арены: с полиморфным аллокатором
+    // внутренний цикл заметно медленнее, а крупные блоки арена всё равно берёт у системы.
+    // Обратные переходы: предшественники состояния target по входу input
+    // лежат в preds[predStart[input * total + target] .. predStart[input * total + target + 1])
+    vector<size_t> predStart(inputs * total + 1, 0);
+    for (uint32_t state = 0; state < total; state++) {
+        for (size_t input = 0; input < inputs; input++) {
+            predStart[input * total + successor(state, input) + 1]++;
+        }
+    }
+    for (size_t i = 1; i < predStart.size(); i++) {
+        predStart[i] += predStart[i - 1];
+    }
+    vector<uint32_t> preds(predStart.back());
+    vector<size_t> fillPos(predStart.begin(), predStart.end() - 1);
+    for (uint32_t state = 0; state < total; state++) {
+        for (size_t input = 0; input < inputs; input++) {
+            preds[fillPos[input * total + successor(state, input)]++] = state;
+        }
+    }
+
+    // Блоки разбиения - отрезки [first, end) массива elems, отмеченные элементы лежат в [first, mid)
+    uint32_t blockCount = initialCount + (hasSink ? 1 : 0);
+    vector<uint32_t> blockOf(total), elems(total), loc(total);
+    vector<uint32_t> first(total + 1, 0), end(total, 0), mid(total, 0);
+    for (uint32_t state = 0; state < total; state++) {
+        blockOf[state] = state == sink ? initialCount : initialClass[state];
+        first[blockOf[state] + 1]++;
+    }
+    for (uint32_t block = 1; block <= blockCount; block++) {
+        first[block] += first[block - 1];
+    }
+    for (uint32_t block = 0; block < blockCount; block++) {
+        end[block] = first[block];
+    }
+    for (uint32_t state = 0; state < total; state++) {
+        uint32_t block = blockOf[state];
+        loc[state] = end[block];
+        elems[end[block]++] = state;
+    }
+    for (uint32_t block = 0; block < blockCount; block++) {
+        mid[block] = first[block];
+    }
+
+    // Очередь делителей: все блоки, кроме самого большого
+    vector<uint32_t> worklist;
+    vector<bool> inWorklist(total, false);
+    uint32_t largest = 0;
+    for (uint32_t block = 1; block < blockCount; block++) {
+        if (end[block] - first[block] > end[largest] - first[largest]) {
+            largest = block;
+        }
+    }
+    for (uint32_t block = 0; block < blockCount; block++) {
+        if (block != largest) {
+            worklist.push_back(block);
+            inWorklist[block] = true;
+        }
+    }
+
+    vector<uint32_t> splitter;
+    vector<uint32_t> touched;
+    while (!worklist.empty()) {
+        uint32_t splitterBlock = worklist.back();
+        worklist.pop_back();
+        inWorklist[splitterBlock] = false;
+        splitter.assign(elems.begin() + first[splitterBlock], elems.begin() + end[splitterBlock]);
+        for (size_t input = 0; input < inputs; input++) {
+            // Отмечаем предшественников делителя по входу input
+            for (uint32_t target : splitter) {
+                size_t predEnd = predStart[input * total + target + 1];
+                for (size_t i = predStart[input * total + target]; i < predEnd; i++) {
+                    uint32_t state = preds[i];
+                    uint32_t block = blockOf[state];
+                    if (loc[state] < mid[block]) {
+                        continue;
+                    }
+                    if (mid[block] == first[block]) {
+                        touched.push_back(block);
+                    }
+                    uint32_t other = elems[mid[block]];
+                    elems[loc[state]] = other;
+                    loc[other] = loc[state];
+                    elems[mid[block]] = state;
+                    loc[state] = mid[block];
+                    mid[block]++;
+                }
+            }
+            // Делим затронутые блоки, меньшая часть становится новым блоком и делителем
+            for (uint32_t block : touched) {
+                if (mid[block] == end[block]) {
+                    mid[block] = first[block];
+                    continue;
+                }
+                uint32_t newBlock = blockCount++;
+                if (mid[block] - first[block] <= end[block] - mid[block]) {
+                    first[newBlock] = first[block];
+                    end[newBlock] = mid[block];
+                    first[block] = mid[block];
+                }
+                else {
+                    first[newBlock] = mid[block];
+                    end[newBlock] = end[block];
+                    end[block] = mid[block];
+                }
+                mid[block] = first[block];
+                mid[newBlock] = first[newBlock];
+                for (uint32_t pos = first[newBlock]; pos < end[newBlock]; pos++) {
+                    blockOf[elems[pos]] = newBlock;
+                }
+                worklist.push_back(newBlock);
+                inWorklist[newBlock] = true;
+            }
+            touched.clear();
+        }
+    }
+
+    classTable.assign(numStates, 0);
+    pmr::vector<uint32_t> blockClass(blockCount, NO_STATE, CurrentArena());
+    uint32_t classNum = 0;
+    for (uint32_t state = 0; state < numStates; state++) {
+        uint32_t block = blockOf[state];
+        if (blockClass[block] == NO_STATE) {
+            blockClass[block] = classNum++;
+        }
+        classTable[state] = blockClass[block];
+    }
+    return classNum;
+}
+
+// Перемешивание битов хеша: старшие биты выбирают шард, младшие - ячейку в нём
+static uint64_t MixHash(uint64_t hash) {
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDULL;
+    hash ^= hash >> 33;
+    hash *= 0xC4CEB9FE1A85EC53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+const uint32_t SIGNATURE_BLOCK = 1 << 14;
+const unsigned SHARD_BITS = 6;
+
+// Нумерует состояния по сигнатуре: hashBlock(begin, end, hashes) - хеши сигнатур состояний [begin, end),
+// sameState(a, b) - равенство сигнатур.
+// Хеши считаются блоками параллельно, затем состояния раскладываются по шардам с сохранением порядка,
+// и каждый шард независимо находит для состояния первое состояние с той же сигнатурой.
+// Номера классов выдаются последовательным проходом в порядке первой встречи,
+// поэтому результат не зависит от числа потоков
+template <class HashBlock, class SameState>
+static uint32_t NumberBySignature(uint32_t numStates, unsigned threads, HashBlock&& hashBlock, SameState&& sameState, pmr::vector<uint32_t>& classTable)
+{
+    const size_t shardCount = size_t(1) << SHARD_BITS;
+    size_t blockCount = (size_t(numStates) + SIGNATURE_BLOCK - 1) / SIGNATURE_BLOCK;
+    pmr::memory_resource* arena = CurrentArena();
+    pmr::vector<uint64_t> hashes(numStates, arena);
+    // shardPos[block * shardCount + shard]: сначала число состояний блока в шарде, затем позиция блока в order
+    pmr::vector<size_t> shardPos(blockCount * shardCount + 1, 0, arena);
+    auto shardOf = [&](uint32_t state) {
+        return size_t(hashes[state] >> (64 - SHARD_BITS));
+    };
+    auto blockRange = [&](size_t block, uint32_t& begin, uint32_t& end) {
+        begin = uint32_t(block * SIGNATURE_BLOCK);
+        end = uint32_t(min<size_t>(numStates, (block + 1) * SIGNATURE_BLOCK));
+    };
+    RunParallel(blockCount, threads, [&](size_t block) {
+        uint32_t begin, end;
+        blockRange(block, begin, end);
+        size_t* counts = shardPos.data() + block * shardCount;
+        hashBlock(begin, end, hashes.data() + begin);
+        for (uint32_t state = begin; state < end; state++) {
+            hashes[state] = MixHash(hashes[state]);
+            counts[shardOf(state)]++;
+        }
+    });
+    // Шард s занимает отрезок order, внутри него блоки идут по порядку
+    pmr::vector<size_t> shardBegin(shardCount + 1, 0, arena);
+    size_t position = 0;
+    for (size_t shard = 0; shard < shardCount; shard++) {
+        shardBegin[shard] = position;
+        for (size_t block = 0; block < blockCount; block++) {
+            size_t count = shardPos[block * shardCount + shard];
+            shardPos[block * shardCount + shard] = position;
+            position += count;
+        }
+    }
+    shardBegin[shardCount] = position;
+    pmr::vector<uint32_t> order(numStates, arena);
+    RunParallel(blockCount, threads, [&](size_t block) {
+        uint32_t begin, end;
+        blockRange(block, begin, end);
+        size_t* positions = shardPos.data() + block * shardCount;
+        for (uint32_t state = begin; state < end; state++) {
+            order[positions[shardOf(state)]++] = state;
+        }
+    });
+
+    // representative[state] - первое состояние с той же сигнатурой
+    pmr::vector<uint32_t> representative(numStates, arena);
+    RunParallel(shardCount, threads, [&](size_t shard) {
+        size_t begin = shardBegin[shard], end = shardBegin[shard + 1];
+        size_t capacity = 16;
+        while (capacity < (end - begin) * 2) {
+            capacity *= 2;
+        }
+        // номер состояния + 1, 0 - свободная ячейка; таблица выделяется в рабочем потоке, не из арены
+        vector<uint32_t> slots(capacity, 0);
+        size_t mask = capacity - 1;
+        for (size_t i = begin; i < end; i++) {
+            uint32_t state = order[i];
+            size_t slot = size_t(hashes[state]) & mask;
+            while (slots[slot] != 0) {
+                uint32_t candidate = slots[slot] - 1;
+                if (hashes[candidate] == hashes[state] && sameState(candidate, state)) {
+                    break;
+                }
+                slot = (slot + 1) & mask;
+            }
+            if (slots[slot] == 0) {
+                slots[slot] = state + 1;
+            }
+            representative[state] = slots[slot] - 1;
+        }
+    });
+
+    classTable.resize(numStates);
+    uint32_t classNum = 0;
+    for (uint32_t state = 0; state < numStates; state++) {
+        uint32_t first = representative[state];
+        classTable[state] = first == state ? classNum++ : classTable[first];
+    }
+    return classNum;
+}
+
+// Параллельное уточнение: раунды пересчёта сигнатур (класс состояния + классы преемников),
+// как в прежнем алгоритме, но сигнатура только хешируется и сравнивается по месту
+static uint32_t RefinePartitionParallel(const pmr::vector<uint32_t>& next, uint32_t numStates, uint32_t numInputs,
+    const pmr::vector<uint32_t>& initialClass, uint32_t initialCount, pmr::vector<uint32_t>& classTable, unsigned threads)
+{
+    SignatureKernel kernel = DefaultSignatureKernel();
+    classTable = initialClass;
+    uint32_t classCount = initialCount;
+    pmr::vector<uint32_t> newClassTable(CurrentArena());
+    while (true) {
+        auto hashBlock = [&](uint32_t begin, uint32_t end, uint64_t* hashes) {
+            HashSignatures(next.data(), numInputs, classTable.data(), begin, end, hashes, kernel);
+        };
+        auto sameState = [&](uint32_t a, uint32_t b) {
+            return SameSignature(next.data(), numInputs, classTable.data(), a, b, kernel);
+        };
+        uint32_t newCount = NumberBySignature(numStates, threads, hashBlock, sameState, newClassTable);
+        // новое разбиение мельче прежнего, при равном числе классов оно совпадает с ним
+        classTable.swap(newClassTable);
+        if (newCount == classCount) {
+            break;
+        }
+        classCount = newCount;
+    }
+    return classCount;
+}
+
+static uint32_t GroupOutputRowsParallel(const MealyAutomata& aut, pmr::vector<uint32_t>& classTable, unsigned threads) {
+    size_t inputs = aut.numInputs;
+    const uint32_t* outputs = aut.outputs.data();
+    return NumberBySignature(aut.numStates, threads,
+        [&](uint32_t begin, uint32_t end, uint64_t* hashes) {
+            for (uint32_t state = begin; state < end; state++) {
+                hashes[state - begin] = HashRow(outputs + state * inputs, inputs);
+            }
+        },
+        [&](uint32_t a, uint32_t b) {
+            return equal(outputs + a * inputs, outputs + (a + 1) * inputs, outputs + b * inputs);
+        },
+        classTable);
+}
+
+void MinimizeMealy(MealyAutomata& automata, MinimizationEngine engine, unsigned threads) {
+    if (engine == MinimizationEngine::Legacy) {
+        MinimizeMealyLegacy(automata);
+        return;
+    }
+    if (engine == MinimizationEngine::Parallel) {
+        pmr::vector<uint32_t> initialClass(CurrentArena()), classTable(CurrentArena());
+        uint32_t initialCount = GroupOutputRowsParallel(automata, initialClass, threads);
+        uint32_t classCount = RefinePartitionParallel(automata.next, automata.numStates, automata.numInputs, initialClass, initialCount, classTable, threads);
+        CollapseClassesMealy(automata, classTable, classCount);
+        return;
+    }
+    pmr::vector<uint32_t> initialClass(CurrentArena());
+    uint32_t initialCount = GroupOutputRows(automata, initialClass);
+    pmr::vector<uint32_t> classTable(CurrentArena());
+    uint32_t classCount = RefinePartition(automata.next, automata.numStates, automata.numInputs, initialClass, initialCount, classTable);
+    CollapseClassesMealy(automata, classTable, classCount);
+}
+
+void MinimizeMoore(MooreAutomata& automata, MinimizationEngine engine, unsigned threads) {
+    if (engine == MinimizationEngine::Legacy) {
+        MinimizeMooreLegacy(automata);
+        return;
+    }
+    if (engine == MinimizationEngine::Parallel) {
+        pmr::vector<uint32_t> initialClass(CurrentArena()), classTable(CurrentArena());
+        uint32_t initialCount = InitilizeClassTable(automata, initialClass);
+        uint32_t classCount = RefinePartitionParallel(automata.next, automata.numStates, automata.numInputs, initialClass, initialCount, classTable, threads);
+        CollapseClassesMoore(automata, classTable, classCount);
+        return;
+    }
+    pmr::vector<uint32_t> initialClass(CurrentArena());
+    uint32_t initialCount = InitilizeClassTable(automata, initialClass);
+    pmr::vector<uint32_t> classTable(CurrentArena());
+    uint32_t classCount = RefinePartition(automata.next, automata.numStates, automata.numInputs, initialClass, initialCount, classTable);
+    CollapseClassesMoore(automata, classTable, classCount);
+}
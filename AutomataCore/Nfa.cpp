@@ -0,0 +1,172 @@
+﻿#include "Nfa.h"
+#include "MappedFile.h"
+#include "OutputBuffer.h"
+
+#include <iostream>
+
+using namespace std;
+
+// Отрезает от rest поле до separator
+static string_view NextField(string_view& rest, char separator) {
+    size_t end = rest.find(separator);
+    string_view field = rest.substr(0, end);
+    rest = end == string_view::npos ? string_view() : rest.substr(end + 1);
+    return field;
+}
+
+static vector<string_view> SplitNonEmptyLines(string_view data) {
+    vector<string_view> lines;
+    while (!data.empty()) {
+        string_view line = NextField(data, '\n');
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        if (!line.empty()) {
+            lines.push_back(line);
+        }
+    }
+    return lines;
+}
+
+// Раскладка переходов по ячейкам подсчётом: offsets[cell + 1] - конец диапазона ячейки
+static void BuildCsr(const vector<NfaEdge>& edges, size_t cells, size_t width,
+    pmr::vector<uint32_t>& offsets, pmr::vector<uint32_t>& targets, bool epsilon)
+{
+    offsets.assign(cells + 1, 0);
+    for (const NfaEdge& edge : edges) {
+        if ((edge.input == NO_SYMBOL) == epsilon) {
+            offsets[edge.state * width + (epsilon ? 0 : edge.input) + 1]++;
+        }
+    }
+    for (size_t cell = 0; cell < cells; cell++) {
+        offsets[cell + 1] += offsets[cell];
+    }
+    targets.resize(offsets[cells]);
+    pmr::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1, CurrentArena());
+    for (const NfaEdge& edge : edges) {
+        if ((edge.input == NO_SYMBOL) == epsilon) {
+            targets[fill[edge.state * width + (epsilon ? 0 : edge.input)]++] = edge.target;
+        }
+    }
+}
+
+void SetNfaTransitions(Nfa& nfa, const vector<NfaEdge>& edges) {
+    BuildCsr(edges, size_t(nfa.numStates) * nfa.numInputs, nfa.numInputs, nfa.offsets, nfa.targets, false);
+    BuildCsr(edges, nfa.numStates, 1, nfa.epsilonOffsets, nfa.epsilonTargets, true);
+}
+
+Nfa ParseNfaCsv(string_view data) {
+    vector<string_view> lines = SplitNonEmptyLines(data);
+    if (lines.size() < 2) {
+        cerr << "Error: NFA table must start with output and state rows" << endl;
+        return Nfa();
+    }
+    Nfa nfa;
+    string_view cells = lines[1];
+    NextField(cells, ';');
+    while (!cells.empty()) {
+        AddSymbol(nfa.states, NextField(cells, ';'));
+    }
+    nfa.numStates = SymbolCount(nfa.states);
+    cells = lines[0];
+    NextField(cells, ';');
+    for (uint32_t state = 0; state < nfa.numStates; state++) {
+        string_view output = NextField(cells, ';');
+        nfa.outputs.push_back(output.empty() ? NO_SYMBOL : InternSymbol(nfa.outputSymbols, output));
+    }
+
+    vector<NfaEdge> edges;
+    bool ok = true;
+    for (size_t row = 2; row < lines.size(); row++) {
+        cells = lines[row];
+        string_view symbol = NextField(cells, ';');
+        // Повторная строка того же входа дополняет переходы
+        uint32_t input = symbol == EPSILON_SYMBOL ? NO_SYMBOL : InternSymbol(nfa.inputs, symbol);
+        for (uint32_t state = 0; state < nfa.numStates && !cells.empty(); state++) {
+            string_view cell = NextField(cells, ';');
+            while (!cell.empty()) {
+                string_view name = NextField(cell, ',');
+                if (name.empty()) {
+                    continue;
+                }
+                uint32_t target = FindSymbol(nfa.states, name);
+                if (target == NO_SYMBOL) {
+                    cerr << "Error: Unknown state " << name << endl;
+                    ok = false;
+                    continue;
+                }
+                edges.push_back({ state, input, target });
+            }
+        }
+    }
+    if (!ok) {
+        return Nfa();
+    }
+    nfa.numInputs = SymbolCount(nfa.inputs);
+    SetNfaTransitions(nfa, edges);
+    return nfa;
+}
+
+Nfa ReadNfa(const string& filename) {
+    MappedFile file(filename);
+    if (!file.IsOpen()) {
+        cerr << "Error: Could not open file " << filename << endl;
+        return Nfa();
+    }
+    return ParseNfaCsv(file.Data());
+}
+
+// Ячейка: цели [begin, end) через запятую
+static void WriteNfaCell(const Nfa& nfa, const uint32_t* begin, const uint32_t* end, OutputBuffer& file) {
+    file.Append(';');
+    for (const uint32_t* target = begin; target != end; target++) {
+        if (target != begin) {
+            file.Append(',');
+        }
+        file.Append(SymbolName(nfa.states, *target));
+    }
+}
+
+void WriteNfaCsv(const Nfa& nfa, OutputBuffer& file) {
+    for (uint32_t state = 0; state < nfa.numStates; state++) {
+        file.Append(';');
+        file.Append(SymbolName(nfa.outputSymbols, nfa.outputs[state]));
+    }
+    file.Append('\n');
+    for (uint32_t state = 0; state < nfa.numStates; state++) {
+        file.Append(';');
+        file.Append(SymbolName(nfa.states, state));
+    }
+    file.Append('\n');
+    for (uint32_t input = 0; input < nfa.numInputs; input++) {
+        file.Append(SymbolName(nfa.inputs, input));
+        for (uint32_t state = 0; state < nfa.numStates; state++) {
+            size_t cell = size_t(state) * nfa.numInputs + input;
+            WriteNfaCell(nfa, nfa.targets.data() + nfa.offsets[cell], nfa.targets.data() + nfa.offsets[cell + 1], file);
+        }
+        file.Append('\n');
+    }
+    if (nfa.epsilonTargets.empty()) {
+        return;
+    }
+    file.Append(EPSILON_SYMBOL);
+    for (uint32_t state = 0; state < nfa.numStates; state++) {
+        WriteNfaCell(nfa, nfa.epsilonTargets.data() + nfa.epsilonOffsets[state],
+            nfa.epsilonTargets.data() + nfa.epsilonOffsets[state + 1], file);
+    }
+    file.Append('\n');
+}
+
+bool SaveNfa(const Nfa& nfa, const string& filename) {
+    OutputBuffer file(filename);
+    if (!file.IsOpen()) {
+        cerr << "Failed to open file: " << filename << endl;
+        return false;
+    }
+    WriteNfaCsv(nfa, file);
+    if (!file.Close()) {
+        cerr << "Failed to write file: " << filename << endl;
+        return false;
+    }
+    return true;
+}
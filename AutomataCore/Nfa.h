@@ -0,0 +1,60 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "AutomataCore.h"
+
+// Строка пустых переходов в таблице НКА, которую пишет RegGr
+const std::string EPSILON_SYMBOL = "ε";
+const std::string DFA_STATE_CH = "S";
+// Состояния НКА из грамматики или выражения - q0, q1, ...; конечные отмечены выходом F
+const std::string NFA_STATE_CH = "q";
+const std::string FINAL_MARK = "F";
+
+// НКА в виде CSR: цели перехода из state по input - targets[offsets[cell], offsets[cell + 1]),
+// cell = state * numInputs + input. Пустые переходы хранятся так же, по одному диапазону на состояние.
+// Начальное состояние - 0 (первый столбец)
+struct Nfa {
+    uint32_t numStates = 0;
+    // входы без ε
+    uint32_t numInputs = 0;
+    std::pmr::vector<uint32_t> offsets{ CurrentArena() };
+    std::pmr::vector<uint32_t> targets{ CurrentArena() };
+    std::pmr::vector<uint32_t> epsilonOffsets{ CurrentArena() };
+    std::pmr::vector<uint32_t> epsilonTargets{ CurrentArena() };
+    // outputs[state]; пустая отметка - NO_SYMBOL
+    std::pmr::vector<uint32_t> outputs{ CurrentArena() };
+    SymbolTable states;
+    SymbolTable inputs;
+    SymbolTable outputSymbols;
+};
+
+// Переход НКА до раскладки в CSR; input == NO_SYMBOL - пустой переход
+struct NfaEdge {
+    uint32_t state;
+    uint32_t input;
+    uint32_t target;
+};
+
+// Раскладывает edges по ячейкам nfa (numStates и numInputs уже заданы);
+// цели в ячейке идут в порядке edges
+void SetNfaTransitions(Nfa& nfa, const std::vector<NfaEdge>& edges);
+
+// Таблица RegGr: строка отметок (F - конечное), строка состояний, строки входов
+// с целями через запятую. Пустой НКА, если файл не прочитан
+Nfa ParseNfaCsv(std::string_view data);
+Nfa ReadNfa(const std::string& filename);
+// Запись в том же формате; строка ε - последняя, если есть пустые переходы
+void WriteNfaCsv(const Nfa& nfa, OutputBuffer& buffer);
+bool SaveNfa(const Nfa& nfa, const std::string& filename);
+
+// Построение подмножеств: ε-замыкания считаются один раз, подмножества хранятся
+// отсортированными в общем пуле и склеиваются по хешу. Состояния S0, S1, ... нумеруются
+// в порядке обхода в ширину, пустое подмножество - отсутствующий переход.
+// Выход состояния - наименьшая непустая отметка среди элементов его замыкания, без отметок - пустая строка.
+// threads > 1 - фронт обхода раскрывается параллельно, номера состояний те же, что при одном потоке
+MooreAutomata DeterminizeNfa(const Nfa& nfa, unsigned threads = 1);
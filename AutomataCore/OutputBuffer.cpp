@@ -0,0 +1,86 @@
+﻿#include "OutputBuffer.h"
+
+#include <charconv>
+#include <cstring>
+
+using namespace std;
+
+OutputBuffer::OutputBuffer(const string& path, size_t capacity) : buffer(capacity) {
+    file = fopen(path.c_str(), "wb");
+    if (file != nullptr) {
+        // буферизация stdio не нужна, блоки и так крупные
+        setvbuf(file, nullptr, _IONBF, 0);
+    }
+}
+
+OutputBuffer::OutputBuffer(string& target, size_t capacity) : target(&target), buffer(capacity) {}
+
+OutputBuffer::OutputBuffer(FILE* stream, size_t capacity) : file(stream), ownsFile(false), buffer(capacity) {}
+
+OutputBuffer::~OutputBuffer() {
+    Close();
+}
+
+void OutputBuffer::Append(string_view text) {
+    if (text.size() > buffer.size() - used) {
+        Flush();
+        if (text.size() > buffer.size()) {
+            if (target != nullptr) {
+                target->append(text);
+            }
+            else if (file != nullptr && fwrite(text.data(), 1, text.size(), file) != text.size()) {
+                failed = true;
+            }
+            return;
+        }
+    }
+    memcpy(buffer.data() + used, text.data(), text.size());
+    used += text.size();
+}
+
+void OutputBuffer::Append(char ch) {
+    if (used == buffer.size()) {
+        Flush();
+    }
+    buffer[used++] = ch;
+}
+
+void OutputBuffer::AppendNumber(uint64_t value) {
+    const size_t maxDigits = 20;
+    if (buffer.size() - used < maxDigits) {
+        Flush();
+    }
+    char* begin = buffer.data() + used;
+    used = to_chars(begin, begin + maxDigits, value).ptr - buffer.data();
+}
+
+void OutputBuffer::Flush() {
+    if (target != nullptr) {
+        target->append(buffer.data(), used);
+    }
+    else if (used != 0 && file != nullptr && fwrite(buffer.data(), 1, used, file) != used) {
+        failed = true;
+    }
+    // у чужого потока своя буферизация stdio, её тоже сбрасываем
+    else if (used != 0 && file != nullptr && !ownsFile && fflush(file) != 0) {
+        failed = true;
+    }
+    used = 0;
+}
+
+bool OutputBuffer::Close() {
+    if (target != nullptr) {
+        Flush();
+        target = nullptr;
+        return true;
+    }
+    if (file == nullptr) {
+        return false;
+    }
+    Flush();
+    if ((ownsFile ? fclose(file) : fflush(file)) != 0) {
+        failed = true;
+    }
+    file = nullptr;
+    return !failed;
+}
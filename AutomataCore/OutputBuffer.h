@@ -0,0 +1,39 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Запись в файл через большой буфер: текст собирается в памяти
+// и уходит на диск крупными блоками, без endl и потоков iostream.
+// Вместо файла можно писать в строку - те же функции записи формируют буфер в памяти
+class OutputBuffer {
+public:
+    explicit OutputBuffer(const std::string& path, size_t capacity = 1 << 20);
+    explicit OutputBuffer(std::string& target, size_t capacity = 1 << 16);
+    // Открытый поток (например, stdout): Close сбрасывает буфер, но не закрывает поток
+    explicit OutputBuffer(FILE* stream, size_t capacity = 1 << 16);
+    ~OutputBuffer();
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+    bool IsOpen() const { return file != nullptr || target != nullptr; }
+    void Append(std::string_view text);
+    void Append(char ch);
+    void AppendNumber(uint64_t value);
+    // Отдаёт накопленный текст в файл или строку, не дожидаясь заполнения буфера
+    void Flush();
+    // false, если запись не удалась
+    bool Close();
+
+private:
+
+    FILE* file = nullptr;
+    bool ownsFile = true;
+    std::string* target = nullptr;
+    std::vector<char> buffer;
+    size_t used = 0;
+    bool failed = false;
+};
@@ -0,0 +1,44 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// 0 - по числу аппаратных потоков
+inline unsigned ResolveThreadCount(unsigned requested) {
+    if (requested != 0) {
+        return requested;
+    }
+    unsigned hardware = std::thread::hardware_concurrency();
+    return hardware == 0 ? 1 : hardware;
+}
+
+// Выполняет task(i) для всех i из [0, taskCount) на threads потоках.
+// Потоки разбирают задачи по одной через общий счётчик, вызывающий поток тоже работает
+template <class Task>
+void RunParallel(size_t taskCount, unsigned threads, Task&& task) {
+    size_t workers = std::min<size_t>(threads, taskCount);
+    if (workers <= 1) {
+        for (size_t i = 0; i < taskCount; i++) {
+            task(i);
+        }
+        return;
+    }
+    std::atomic<size_t> nextTask{ 0 };
+    auto worker = [&]() {
+        for (size_t i = nextTask++; i < taskCount; i = nextTask++) {
+            task(i);
+        }
+    };
+    std::vector<std::thread> pool;
+    pool.reserve(workers - 1);
+    for (size_t w = 1; w < workers; w++) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : pool) {
+        thread.join();
+    }
+}
@@ -0,0 +1,51 @@
+﻿#include "PipelineStats.h"
+
+#include <iostream>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+using namespace std;
+
+size_t PeakMemoryBytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.PeakWorkingSetSize;
+    }
+    return 0;
+#else
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#ifdef __APPLE__
+    return size_t(usage.ru_maxrss);
+#else
+    // в Linux ru_maxrss в килобайтах
+    return size_t(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+PipelineStats::PipelineStats(bool enabled) : enabled(enabled), last(chrono::steady_clock::now()) {}
+
+void PipelineStats::Mark(const string& stage) {
+    if (!enabled) {
+        return;
+    }
+    auto now = chrono::steady_clock::now();
+    auto elapsed = chrono::duration_cast<chrono::milliseconds>(now - last).count();
+    last = now;
+    cerr << "stats: " << stage << " " << elapsed << " ms, peak memory " << PeakMemoryBytes() / 1024 << " KiB" << endl;
+}
+
+void PrintArenaStats(const Arena& arena) {
+    ArenaStats stats = arena.Stats();
+    cerr << "arena: high-water " << stats.peakBytes / 1024 << " KiB, requested " << stats.requestedBytes / 1024
+        << " KiB in " << stats.allocations << " allocations" << endl;
+}
@@ -0,0 +1,25 @@
+﻿#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+#include "Arena.h"
+
+// Пиковый объём памяти процесса (resident set) в байтах, 0 - если система не сообщает
+size_t PeakMemoryBytes();
+
+// Вывод в cerr времени стадии и пика памяти после неё (флаг --stats)
+class PipelineStats {
+public:
+    explicit PipelineStats(bool enabled);
+
+    void Mark(const std::string& stage);
+
+private:
+    bool enabled;
+    std::chrono::steady_clock::time_point last;
+};
+
+// Вывод в cerr пика памяти арены и числа выделений (флаг --arena-stats)
+void PrintArenaStats(const Arena& arena);
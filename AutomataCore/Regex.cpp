@@ -0,0 +1,185 @@
+﻿#include "Regex.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// Часть выражения для построения Глушкова: допускает ли она пустую строку,
+// позиции, с которых она может начаться и которыми закончиться
+struct RegexPart {
+    bool nullable = true;
+    vector<uint32_t> first;
+    vector<uint32_t> last;
+};
+
+// Разбор спуском с вычислением частей на ходу, без дерева выражения.
+// Столбец считается в символах Юникода
+struct RegexParser {
+    string_view pattern;
+    size_t pos = 0;
+    size_t column = 1;
+    // литералы в порядке первой встречи
+    SymbolTable symbols;
+    // positionSymbols[p - 1] - литерал позиции p
+    vector<uint32_t> positionSymbols;
+    // (q, p): за позицией q может идти позиция p, q = 0 - начало слова
+    vector<pair<uint32_t, uint32_t>> follows;
+};
+
+[[noreturn]] static void ThrowRegexError(size_t column, const string& message) {
+    throw runtime_error("column " + to_string(column) + ": " + message);
+}
+
+static bool AtEnd(const RegexParser& parser) {
+    return parser.pos == parser.pattern.size();
+}
+
+static char Peek(const RegexParser& parser) {
+    return parser.pattern[parser.pos];
+}
+
+static void Advance(RegexParser& parser, size_t length = 1) {
+    parser.pos += length;
+    parser.column++;
+}
+
+static void AddFollows(RegexParser& parser, const vector<uint32_t>& from, const vector<uint32_t>& to) {
+    for (uint32_t q : from) {
+        for (uint32_t p : to) {
+            parser.follows.emplace_back(q, p);
+        }
+    }
+}
+
+static RegexPart ParseAlternation(RegexParser& parser);
+
+static RegexPart ParseAtom(RegexParser& parser) {
+    size_t column = parser.column;
+    char ch = Peek(parser);
+    if (ch == '(') {
+        Advance(parser);
+        if (!AtEnd(parser) && Peek(parser) == ')') {
+            Advance(parser);
+            return RegexPart();
+        }
+        RegexPart part = ParseAlternation(parser);
+        if (AtEnd(parser)) {
+            ThrowRegexError(column, "unclosed '('");
+        }
+        Advance(parser);
+        return part;
+    }
+    if (ch == '*' || ch == '+') {
+        ThrowRegexError(column, string("unexpected operator '") + ch + "'");
+    }
+    size_t length = Utf8Length(parser.pattern, parser.pos);
+    if (length == 0) {
+        ThrowRegexError(column, "invalid UTF-8");
+    }
+    string_view literal = parser.pattern.substr(parser.pos, length);
+    Advance(parser, length);
+    if (literal == EPSILON_SYMBOL) {
+        return RegexPart();
+    }
+    parser.positionSymbols.push_back(InternSymbol(parser.symbols, literal));
+    uint32_t position = static_cast<uint32_t>(parser.positionSymbols.size());
+    RegexPart part;
+    part.nullable = false;
+    part.first.push_back(position);
+    part.last.push_back(position);
+    return part;
+}
+
+// Повторение: из любой последней позиции можно снова перейти в любую первую
+static RegexPart ParseRepeat(RegexParser& parser) {
+    RegexPart part = ParseAtom(parser);
+    while (!AtEnd(parser) && (Peek(parser) == '*' || Peek(parser) == '+')) {
+        AddFollows(parser, part.last, part.first);
+        part.nullable = part.nullable || Peek(parser) == '*';
+        Advance(parser);
+    }
+    return part;
+}
+
+static RegexPart ParseConcat(RegexParser& parser) {
+    if (AtEnd(parser) || Peek(parser) == '|' || Peek(parser) == ')') {
+        ThrowRegexError(parser.column, "empty alternative");
+    }
+    RegexPart result = ParseRepeat(parser);
+    while (!AtEnd(parser) && Peek(parser) != '|' && Peek(parser) != ')') {
+        RegexPart next = ParseRepeat(parser);
+        AddFollows(parser, result.last, next.first);
+        if (result.nullable) {
+            result.first.insert(result.first.end(), next.first.begin(), next.first.end());
+        }
+        if (next.nullable) {
+            next.last.insert(next.last.end(), result.last.begin(), result.last.end());
+        }
+        result.last = move(next.last);
+        result.nullable = result.nullable && next.nullable;
+    }
+    return result;
+}
+
+static RegexPart ParseAlternation(RegexParser& parser) {
+    RegexPart result = ParseConcat(parser);
+    while (!AtEnd(parser) && Peek(parser) == '|') {
+        Advance(parser);
+        RegexPart next = ParseConcat(parser);
+        result.nullable = result.nullable || next.nullable;
+        result.first.insert(result.first.end(), next.first.begin(), next.first.end());
+        result.last.insert(result.last.end(), next.last.begin(), next.last.end());
+    }
+    return result;
+}
+
+Nfa RegexToNfa(string_view pattern) {
+    RegexParser parser;
+    parser.pattern = pattern;
+    RegexPart root = ParseAlternation(parser);
+    if (!AtEnd(parser)) {
+        ThrowRegexError(parser.column, "unexpected ')'");
+    }
+
+    Nfa nfa;
+    nfa.numStates = static_cast<uint32_t>(parser.positionSymbols.size()) + 1;
+    GenerateSymbols(nfa.states, NFA_STATE_CH, nfa.numStates);
+    vector<uint32_t> order(SymbolCount(parser.symbols));
+    for (uint32_t id = 0; id < order.size(); id++) {
+        order[id] = id;
+    }
+    sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return SymbolName(parser.symbols, a) < SymbolName(parser.symbols, b);
+    });
+    vector<uint32_t> inputIndex(order.size());
+    for (uint32_t id : order) {
+        inputIndex[id] = AddSymbol(nfa.inputs, SymbolName(parser.symbols, id));
+    }
+    nfa.numInputs = SymbolCount(nfa.inputs);
+
+    uint32_t finalOutput = InternSymbol(nfa.outputSymbols, FINAL_MARK);
+    nfa.outputs.assign(nfa.numStates, NO_SYMBOL);
+    for (uint32_t position : root.last) {
+        nfa.outputs[position] = finalOutput;
+    }
+    if (root.nullable) {
+        nfa.outputs[0] = finalOutput;
+    }
+    for (uint32_t position : root.first) {
+        parser.follows.emplace_back(0, position);
+    }
+    // Повторения вроде (a*)* дают одну пару несколько раз
+    sort(parser.follows.begin(), parser.follows.end());
+    parser.follows.erase(unique(parser.follows.begin(), parser.follows.end()), parser.follows.end());
+    vector<NfaEdge> edges;
+    edges.reserve(parser.follows.size());
+    for (const auto& [from, to] : parser.follows) {
+        edges.push_back({ from, inputIndex[parser.positionSymbols[to - 1]], to });
+    }
+    SetNfaTransitions(nfa, edges);
+    return nfa;
+}
@@ -0,0 +1,13 @@
+﻿#pragma once
+
+#include <string_view>
+
+#include "Nfa.h"
+
+// Регулярное выражение в синтаксисе lw5: ( ) - группа, | - выбор, * - ноль и более повторений,
+// + - одно и более; любой другой символ UTF-8 - литерал, () и ε - пустая строка.
+// Результат - позиционный автомат Глушкова без пустых переходов: состояние q0 - начальное,
+// q1, q2, ... - литералы слева направо, переход по символу ведёт только в позицию с этим символом.
+// Конечные состояния отмечены выходом F, входы - по возрастанию байтов UTF-8.
+// Ошибки - исключения std::runtime_error с номером столбца
+Nfa RegexToNfa(std::string_view pattern);
@@ -0,0 +1,169 @@
+﻿#include "SignatureKernel.h"
+#include "AutomataCore.h"
+
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SIGNATURE_KERNEL_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+using namespace std;
+
+// Хеш сигнатуры: классы преемников распределяются по 8 полосам (вход i - полоса i % 8),
+// в каждой полосе FNV-1a по 32-битным словам, затем полосы и класс состояния сводятся в 64 бита
+const unsigned HASH_LANES = 8;
+const uint32_t LANE_PRIME = 0x01000193;
+const uint32_t LANE_SEEDS[HASH_LANES] = {
+    0x811C9DC5, 0x050C5D1F, 0x6C8E9CF5, 0x2F8E5B4B, 0x9E3779B9, 0x7F4A7C15, 0xBB67AE85, 0x3C6EF372
+};
+
+static uint32_t ClassOfSuccessor(const uint32_t* classTable, uint32_t state) {
+    return state == NO_STATE ? NO_STATE : classTable[state];
+}
+
+static uint64_t CombineLanes(uint32_t stateClass, const uint32_t* lanes) {
+    uint64_t hash = 0xCBF29CE484222325ULL ^ stateClass;
+    for (unsigned lane = 0; lane < HASH_LANES; lane++) {
+        hash = (hash ^ lanes[lane]) * 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+static void HashSignaturesScalar(const uint32_t* next, uint32_t numInputs, const uint32_t* classTable,
+    uint32_t begin, uint32_t end, uint64_t* hashes)
+{
+    for (uint32_t state = begin; state < end; state++) {
+        const uint32_t* row = next + size_t(state) * numInputs;
+        uint32_t lanes[HASH_LANES];
+        copy(LANE_SEEDS, LANE_SEEDS + HASH_LANES, lanes);
+        for (uint32_t input = 0; input < numInputs; input++) {
+            uint32_t& lane = lanes[input % HASH_LANES];
+            lane = (lane ^ ClassOfSuccessor(classTable, row[input])) * LANE_PRIME;
+        }
+        hashes[state - begin] = CombineLanes(classTable[state], lanes);
+    }
+}
+
+static bool SameSignatureScalar(const uint32_t* next, uint32_t numInputs, const uint32_t* classTable, uint32_t a, uint32_t b) {
+    if (classTable[a] != classTable[b]) {
+        return false;
+    }
+    const uint32_t* rowA = next + size_t(a) * numInputs;
+    const uint32_t* rowB = next + size_t(b) * numInputs;
+    for (uint32_t input = 0; input < numInputs; input++) {
+        if (ClassOfSuccessor(classTable, rowA[input]) != ClassOfSuccessor(classTable, rowB[input])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#ifdef SIGNATURE_KERNEL_X86
+
+// Классы 8 преемников: пустые переходы (NO_STATE = -1) не читают таблицу и дают NO_STATE
+TARGET_AVX2 static __m256i GatherClasses(const uint32_t* classTable, const uint32_t* row) {
+    const __m256i noState = _mm256_set1_epi32(-1);
+    __m256i states = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row));
+    __m256i valid = _mm256_xor_si256(_mm256_cmpeq_epi32(states, noState), noState);
+    return _mm256_mask_i32gather_epi32(noState, reinterpret_cast<const int*>(classTable), states, valid, 4);
+}
+
+TARGET_AVX2 static void HashSignaturesAvx2(const uint32_t* next, uint32_t numInputs, const uint32_t* classTable,
+    uint32_t begin, uint32_t end, uint64_t* hashes)
+{
+    const __m256i prime = _mm256_set1_epi32(LANE_PRIME);
+    const __m256i seeds = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(LANE_SEEDS));
+    uint32_t vectorInputs = numInputs - numInputs % HASH_LANES;
+    for (uint32_t state = begin; state < end; state++) {
+        const uint32_t* row = next + size_t(state) * numInputs;
+        __m256i lanesVector = seeds;
+        for (uint32_t input = 0; input < vectorInputs; input += HASH_LANES) {
+            lanesVector = _mm256_mullo_epi32(_mm256_xor_si256(lanesVector, GatherClasses(classTable, row + input)), prime);
+        }
+        alignas(32) uint32_t lanes[HASH_LANES];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), lanesVector);
+        for (uint32_t input = vectorInputs; input < numInputs; input++) {
+            uint32_t& lane = lanes[input % HASH_LANES];
+            lane = (lane ^ ClassOfSuccessor(classTable, row[input])) * LANE_PRIME;
+        }
+        hashes[state - begin] = CombineLanes(classTable[state], lanes);
+    }
+}
+
+TARGET_AVX2 static bool SameSignatureAvx2(const uint32_t* next, uint32_t numInputs, const uint32_t* classTable, uint32_t a, uint32_t b) {
+    if (classTable[a] != classTable[b]) {
+        return false;
+    }
+    const uint32_t* rowA = next + size_t(a) * numInputs;
+    const uint32_t* rowB = next + size_t(b) * numInputs;
+    uint32_t vectorInputs = numInputs - numInputs % HASH_LANES;
+    for (uint32_t input = 0; input < vectorInputs; input += HASH_LANES) {
+        __m256i equalClasses = _mm256_cmpeq_epi32(GatherClasses(classTable, rowA + input), GatherClasses(classTable, rowB + input));
+        if (_mm256_movemask_epi8(equalClasses) != -1) {
+            return false;
+        }
+    }
+    for (uint32_t input = vectorInputs; input < numInputs; input++) {
+        if (ClassOfSuccessor(classTable, rowA[input]) != ClassOfSuccessor(classTable, rowB[input])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#endif
+
+bool CpuHasAvx2() {
+#if !defined(SIGNATURE_KERNEL_X86)
+    return false;
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    bool avx2 = (info[1] & (1 << 5)) != 0;
+    __cpuid(info, 1);
+    // AVX и сохранение регистров ymm операционной системой
+    bool osxsave = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0;
+    return avx2 && osxsave && (_xgetbv(0) & 6) == 6;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+SignatureKernel DefaultSignatureKernel() {
+    static const bool hasAvx2 = CpuHasAvx2();
+    return hasAvx2 ? SignatureKernel::Avx2 : SignatureKernel::Scalar;
+}
+
+void HashSignatures(const uint32_t* next, uint32_t numInputs, const uint32_t* classTable,
+    uint32_t begin, uint32_t end, uint64_t* hashes, SignatureKernel kernel)
+{
+#ifdef SIGNATURE_KERNEL_X86
+    if (kernel == SignatureKernel::Avx2) {
+        HashSignaturesAvx2(next, numInputs, classTable, begin, end, hashes);
+        return;
+    }
+#endif
+    HashSignaturesScalar(next, numInputs, classTable, begin, end, hashes);
+}
+
+bool SameSignature(const uint32_t* next, uint32_t numInputs, const uint32_t* classTable,
+    uint32_t a, uint32_t b, SignatureKernel kernel)
+{
+#ifdef SIGNATURE_KERNEL_X86
+    if (kernel == SignatureKernel::Avx2) {
+        return SameSignatureAvx2(next, numInputs, classTable, a, b);
+    }
+#endif
+    return SameSignatureScalar(next, numInputs, classTable, a, b);
+}
@@ -0,0 +1,25 @@
+﻿#pragma once
+
+#include <cstdint>
+
+// Сигнатура состояния при уточнении разбиения: его класс и классы преемников
+// (NO_STATE для пустого перехода). Строка сигнатуры не хранится:
+// классы преемников собираются из next и classTable прямо при хешировании и сравнении
+enum class SignatureKernel {
+    Scalar,
+    // 8 входов за шаг: gather классов и хеш по 8 полосам
+    Avx2
+};
+
+// AVX2 поддерживается процессором и сохраняется ОС; общая проверка для SIMD-ядер библиотеки
+bool CpuHasAvx2();
+
+// Avx2, если процессор его поддерживает
+SignatureKernel DefaultSignatureKernel();
+
+// hashes[i] - хеш сигнатуры состояния begin + i. Оба варианта дают одинаковые хеши
+void HashSignatures(const uint32_t* next, uint32_t numInputs, const uint32_t* classTable,
+    uint32_t begin, uint32_t end, uint64_t* hashes, SignatureKernel kernel);
+
+bool SameSignature(const uint32_t* next, uint32_t numInputs, const uint32_t* classTable,
+    uint32_t a, uint32_t b, SignatureKernel kernel);
@@ -0,0 +1,268 @@
+﻿#include "StreamKernel.h"
+#include "SignatureKernel.h"
+
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define STREAM_KERNEL_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+using namespace std;
+
+const size_t MAX_VECTOR_CELLS = size_t(1) << 31;
+
+// Дорожки пакета. Свободная дорожка читает символы занятой (alias), чтобы шаг не ветвился,
+// а её переходы отбрасываются по маске active
+struct BatchLanes {
+    alignas(32) uint32_t state[STREAM_BATCH_LANES];
+    alignas(32) uint32_t output[STREAM_BATCH_LANES];
+    alignas(32) uint32_t active[STREAM_BATCH_LANES];
+    alignas(32) uint64_t pos[STREAM_BATCH_LANES];
+    size_t end[STREAM_BATCH_LANES];
+    size_t stream[STREAM_BATCH_LANES];
+};
+
+StreamKernel DefaultStreamKernel() {
+    static const bool hasAvx2 = CpuHasAvx2();
+    return hasAvx2 ? StreamKernel::Avx2 : StreamKernel::Scalar;
+}
+
+static MachineStep ReadStep(const MachineStep& step) {
+    return step;
+}
+
+static MachineStep ReadStep(const NarrowStep& step) {
+    return { step.next == NARROW_NONE ? NO_STATE : step.next, step.output == NARROW_NONE ? NO_SYMBOL : step.output };
+}
+
+// Делает run шагов всеми занятыми дорожками; останавливается перед шагом,
+// на котором хотя бы одна дорожка упирается в пустой переход или чужой символ
+template <class Step>
+static size_t AdvanceScalar(const Machine& machine, const Step* steps, const uint32_t* symbols, uint32_t* outputs, BatchLanes& lanes, size_t run) {
+    size_t inputs = machine.numInputs;
+    MachineStep taken[STREAM_BATCH_LANES];
+    for (size_t t = 0; t < run; t++) {
+        for (size_t lane = 0; lane < STREAM_BATCH_LANES; lane++) {
+            if (lanes.active[lane] == 0) {
+                continue;
+            }
+            uint32_t symbol = symbols[lanes.pos[lane]];
+            taken[lane] = symbol < inputs ? ReadStep(steps[lanes.state[lane] * inputs + symbol]) : MachineStep{ NO_STATE, NO_SYMBOL };
+            if (taken[lane].next == NO_STATE) {
+                return t;
+            }
+        }
+        for (size_t lane = 0; lane < STREAM_BATCH_LANES; lane++) {
+            if (lanes.active[lane] == 0) {
+                continue;
+            }
+            if (outputs != nullptr) {
+                outputs[lanes.pos[lane]] = taken[lane].output;
+            }
+            lanes.state[lane] = taken[lane].next;
+            lanes.output[lane] = taken[lane].output;
+            lanes.pos[lane]++;
+        }
+    }
+    return run;
+}
+
+#ifdef STREAM_KERNEL_X86
+
+// Символы 8 дорожек: две выборки по 4 с 64-битными позициями
+TARGET_AVX2 static __m256i GatherSymbols(const uint32_t* symbols, __m256i lowPos, __m256i highPos) {
+    const int* base = reinterpret_cast<const int*>(symbols);
+    __m128i low = _mm256_i64gather_epi32(base, lowPos, 4);
+    __m128i high = _mm256_i64gather_epi32(base, highPos, 4);
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+}
+
+// Переход и выход 8 дорожек. Широкая ячейка - два gather с шагом 8 байт,
+// узкая - один gather, половины слова расширяются до 32 бит (NARROW_NONE -> NO_STATE)
+TARGET_AVX2 static void GatherSteps(const MachineStep* steps, __m256i cell, __m256i valid, __m256i& next, __m256i& output) {
+    const __m256i none = _mm256_set1_epi32(-1);
+    const int* base = reinterpret_cast<const int*>(steps);
+    next = _mm256_mask_i32gather_epi32(none, base, cell, valid, 8);
+    output = _mm256_mask_i32gather_epi32(none, base + 1, cell, valid, 8);
+}
+
+TARGET_AVX2 static void GatherSteps(const NarrowStep* steps, __m256i cell, __m256i valid, __m256i& next, __m256i& output) {
+    const __m256i none = _mm256_set1_epi32(-1);
+    const __m256i narrowNone = _mm256_set1_epi32(NARROW_NONE);
+    __m256i packed = _mm256_mask_i32gather_epi32(none, reinterpret_cast<const int*>(steps), cell, valid, 4);
+    next = _mm256_and_si256(packed, narrowNone);
+    output = _mm256_srli_epi32(packed, 16);
+    next = _mm256_or_si256(next, _mm256_cmpeq_epi32(next, narrowNone));
+    output = _mm256_or_si256(output, _mm256_cmpeq_epi32(output, narrowNone));
+}
+
+template <class Step>
+TARGET_AVX2 static size_t AdvanceAvx2(const Machine& machine, const Step* steps, const uint32_t* symbols, uint32_t* outputs, BatchLanes& lanes, size_t run) {
+    const __m256i noState = _mm256_set1_epi32(-1);
+    const __m256i inputs = _mm256_set1_epi32(static_cast<int>(machine.numInputs));
+    const __m256i lastInput = _mm256_set1_epi32(static_cast<int>(machine.numInputs - 1));
+    const __m256i one = _mm256_set1_epi64x(1);
+    __m256i state[2], output[2], active[2], pos[4];
+    for (size_t half = 0; half < 2; half++) {
+        state[half] = _mm256_load_si256(reinterpret_cast<const __m256i*>(lanes.state + half * 8));
+        output[half] = _mm256_load_si256(reinterpret_cast<const __m256i*>(lanes.output + half * 8));
+        active[half] = _mm256_load_si256(reinterpret_cast<const __m256i*>(lanes.active + half * 8));
+    }
+    for (size_t quarter = 0; quarter < 4; quarter++) {
+        pos[quarter] = _mm256_load_si256(reinterpret_cast<const __m256i*>(lanes.pos + quarter * 4));
+    }
+    size_t t = 0;
+    for (; t < run; t++) {
+        __m256i next[2], taken[2];
+        int stopped = 0;
+        for (size_t half = 0; half < 2; half++) {
+            __m256i symbol = GatherSymbols(symbols, pos[half * 2], pos[half * 2 + 1]);
+            __m256i valid = _mm256_cmpeq_epi32(_mm256_min_epu32(symbol, lastInput), symbol);
+            __m256i cell = _mm256_add_epi32(_mm256_mullo_epi32(state[half], inputs), symbol);
+            GatherSteps(steps, cell, valid, next[half], taken[half]);
+            stopped |= _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi32(next[half], noState), active[half]));
+        }
+        if (stopped != 0) {
+            break;
+        }
+        if (outputs != nullptr) {
+            alignas(32) uint32_t stepOutputs[STREAM_BATCH_LANES];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(stepOutputs), taken[0]);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(stepOutputs + 8), taken[1]);
+            for (size_t lane = 0; lane < STREAM_BATCH_LANES; lane++) {
+                if (lanes.active[lane] != 0) {
+                    outputs[lanes.pos[lane] + t] = stepOutputs[lane];
+                }
+            }
+        }
+        for (size_t half = 0; half < 2; half++) {
+            state[half] = _mm256_blendv_epi8(state[half], next[half], active[half]);
+            output[half] = _mm256_blendv_epi8(output[half], taken[half], active[half]);
+        }
+        for (size_t quarter = 0; quarter < 4; quarter++) {
+            pos[quarter] = _mm256_add_epi64(pos[quarter], one);
+        }
+    }
+    for (size_t half = 0; half < 2; half++) {
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes.state + half * 8), state[half]);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes.output + half * 8), output[half]);
+    }
+    for (size_t lane = 0; lane < STREAM_BATCH_LANES; lane++) {
+        if (lanes.active[lane] != 0) {
+            lanes.pos[lane] += t;
+        }
+    }
+    return t;
+}
+
+#endif
+
+template <class Step>
+static void SimulateStreamsIn(const Machine& machine, const Step* steps, size_t cells, const uint32_t* symbols, uint32_t* outputs,
+    vector<StreamSpan>& streams, StreamKernel kernel)
+{
+#ifndef STREAM_KERNEL_X86
+    kernel = StreamKernel::Scalar;
+#endif
+    if (machine.numInputs == 0 || cells >= MAX_VECTOR_CELLS) {
+        kernel = StreamKernel::Scalar;
+    }
+    size_t inputs = machine.numInputs;
+    BatchLanes lanes;
+    size_t nextStream = 0;
+    auto start = [&](size_t lane) {
+        while (nextStream < streams.size()) {
+            StreamSpan& span = streams[nextStream];
+            span.done = 0;
+            span.state = 0;
+            span.output = machine.initialOutput;
+            if (span.length != 0 && machine.numStates != 0) {
+                lanes.state[lane] = 0;
+                lanes.output[lane] = machine.initialOutput;
+                lanes.active[lane] = UINT32_MAX;
+                lanes.pos[lane] = span.begin;
+                lanes.end[lane] = span.begin + span.length;
+                lanes.stream[lane] = nextStream++;
+                return true;
+            }
+            nextStream++;
+        }
+        lanes.active[lane] = 0;
+        return false;
+    };
+    size_t active = 0;
+    for (size_t lane = 0; lane < STREAM_BATCH_LANES; lane++) {
+        active += start(lane) ? 1 : 0;
+    }
+    while (active > 0) {
+        size_t run = SIZE_MAX;
+        size_t busyLane = 0;
+        for (size_t lane = 0; lane < STREAM_BATCH_LANES; lane++) {
+            if (lanes.active[lane] != 0) {
+                run = min<size_t>(run, lanes.end[lane] - lanes.pos[lane]);
+                busyLane = lane;
+            }
+        }
+        for (size_t lane = 0; lane < STREAM_BATCH_LANES; lane++) {
+            if (lanes.active[lane] == 0) {
+                lanes.state[lane] = 0;
+                lanes.pos[lane] = lanes.pos[busyLane];
+            }
+        }
+#ifdef STREAM_KERNEL_X86
+        size_t advanced = kernel == StreamKernel::Avx2
+            ? AdvanceAvx2(machine, steps, symbols, outputs, lanes, run)
+            : AdvanceScalar(machine, steps, symbols, outputs, lanes, run);
+#else
+        size_t advanced = AdvanceScalar(machine, steps, symbols, outputs, lanes, run);
+#endif
+        // Шаг, на котором кто-то остановился, дорожки делают по одной
+        bool stalled = advanced < run;
+        for (size_t lane = 0; lane < STREAM_BATCH_LANES; lane++) {
+            if (lanes.active[lane] == 0) {
+                continue;
+            }
+            bool stopped = false;
+            if (stalled) {
+                size_t pos = lanes.pos[lane];
+                uint32_t symbol = symbols[pos];
+                MachineStep step = symbol < inputs ? ReadStep(steps[lanes.state[lane] * inputs + symbol]) : MachineStep{ NO_STATE, NO_SYMBOL };
+                stopped = step.next == NO_STATE;
+                if (!stopped) {
+                    if (outputs != nullptr) {
+                        outputs[pos] = step.output;
+                    }
+                    lanes.state[lane] = step.next;
+                    lanes.output[lane] = step.output;
+                    lanes.pos[lane]++;
+                }
+            }
+            if (stopped || lanes.pos[lane] == lanes.end[lane]) {
+                StreamSpan& span = streams[lanes.stream[lane]];
+                span.done = lanes.pos[lane] - span.begin;
+                span.state = lanes.state[lane];
+                span.output = lanes.output[lane];
+                if (!start(lane)) {
+                    active--;
+                }
+            }
+        }
+    }
+}
+
+void SimulateStreams(const Machine& machine, const uint32_t* symbols, uint32_t* outputs,
+    vector<StreamSpan>& streams, StreamKernel kernel)
+{
+    if (machine.narrowSteps.empty()) {
+        SimulateStreamsIn(machine, machine.steps.data(), machine.steps.size(), symbols, outputs, streams, kernel);
+    }
+    else {
+        SimulateStreamsIn(machine, machine.narrowSteps.data(), machine.narrowSteps.size(), symbols, outputs, streams, kernel);
+    }
+}
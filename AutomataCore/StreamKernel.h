@@ -0,0 +1,30 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Execution.h"
+
+// Пакетное исполнение: STREAM_BATCH_LANES потоков идут в ногу, на каждом шаге все дорожки
+// делают по переходу. Рассчитано на минимизированные таблицы (LoadMachine с minimize)
+// и на множество коротких независимых входов
+enum class StreamKernel {
+    Scalar,
+    // переходы и выходы всех дорожек - gather по ячейкам steps, по 8 дорожек за инструкцию
+    Avx2
+};
+
+// Avx2, если процессор его поддерживает
+StreamKernel DefaultStreamKernel();
+
+const size_t STREAM_BATCH_LANES = 16;
+// Выигрыш AVX2 есть, пока таблица помещается в L2; на больших таблицах шаг упирается в промахи кэша,
+// и вперемешку (RunStreams) быстрее
+const size_t LOCKSTEP_TABLE_BYTES = 512 * 1024;
+
+// Прогоняет потоки с начального состояния и заполняет done, state и output у StreamSpan.
+// outputs[begin + i] - выход на i-м символе потока; nullptr - нужен только итог потока.
+// Результат тот же, что у RunStreams. Номера ячеек считаются в 32 битах,
+// поэтому таблицы от 2^31 ячеек исполняются скалярно
+void SimulateStreams(const Machine& machine, const uint32_t* symbols, uint32_t* outputs,
+    std::vector<StreamSpan>& streams, StreamKernel kernel);
@@ -0,0 +1,72 @@
+﻿#include "AutomataCore.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+
+using namespace std;
+
+// Обработка запроса целиком в памяти: буфер -> автомат Мили -> удаление недостижимых ->
+// минимизация -> автомат Мура -> буфер. Аргументы: [states] [inputs] [outputs] [requests]
+static string GenerateMealyCsv(uint32_t numStates, uint32_t numInputs, uint32_t numOutputs) {
+    mt19937 random(7);
+    string csv;
+    for (uint32_t state = 0; state < numStates; state++) {
+        csv += ";s" + to_string(state);
+    }
+    csv += '\n';
+    for (uint32_t input = 0; input < numInputs; input++) {
+        csv += "x" + to_string(input) + ";";
+        for (uint32_t state = 0; state < numStates; state++) {
+            csv += "s" + to_string(random() % numStates) + "/y" + to_string(random() % numOutputs);
+            if (state != numStates - 1) {
+                csv += ';';
+            }
+        }
+        csv += '\n';
+    }
+    return csv;
+}
+
+static string HandleRequest(string_view request, AutomataFormat format) {
+    MealyAutomata mealy;
+    if (!LoadMealyFromBuffer(request, mealy)) {
+        return string();
+    }
+    RemoveUnreachableStatesMealy(mealy);
+    MinimizeMealy(mealy);
+    MooreAutomata moore = AltConvertMealyToMoore(move(mealy));
+    MinimizeMoore(moore);
+    return SaveMooreToBuffer(moore, format);
+}
+
+static void Measure(const string& name, const string& request, AutomataFormat format, unsigned requests) {
+    size_t responseSize = 0;
+    auto start = chrono::steady_clock::now();
+    for (unsigned i = 0; i < requests; i++) {
+        responseSize += HandleRequest(request, format).size();
+    }
+    chrono::duration<double, micro> elapsed = chrono::steady_clock::now() - start;
+    cout << name << ": " << elapsed.count() / requests << " us/request, request " << request.size()
+        << " bytes, response " << responseSize / requests << " bytes" << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    uint32_t numStates = argc > 1 ? strtoul(argv[1], nullptr, 10) : 200;
+    uint32_t numInputs = argc > 2 ? strtoul(argv[2], nullptr, 10) : 4;
+    uint32_t numOutputs = argc > 3 ? strtoul(argv[3], nullptr, 10) : 2;
+    unsigned requests = argc > 4 ? strtoul(argv[4], nullptr, 10) : 1000;
+
+    string csvRequest = GenerateMealyCsv(numStates, numInputs, numOutputs);
+    MealyAutomata parsed;
+    LoadMealyFromBuffer(csvRequest, parsed);
+    string binaryRequest = SaveMealyToBuffer(parsed, AutomataFormat::Binary);
+    cout << "states " << numStates << ", inputs " << numInputs << ", outputs " << numOutputs
+        << ", requests " << requests << endl;
+    Measure("csv", csvRequest, AutomataFormat::Csv, requests);
+    Measure("binary", binaryRequest, AutomataFormat::Binary, requests);
+    return 0;
+}
@@ -0,0 +1,107 @@
+﻿#include "AutomataCore.h"
+#include "Execution.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+// Влияние порядка состояний и узких ячеек на исполнение и минимизацию.
+// Автомат Мили с горячим ядром: большинство переходов ведёт в небольшое подмножество состояний,
+// разбросанное по таблице, как бывает после построения подмножеств. Частотный порядок строится
+// по образцу, замер - на других входах того же распределения.
+// Аргументы: [inputs] [symbols] [hot_percent]
+static MealyAutomata HotCoreMealy(uint32_t numStates, uint32_t numInputs, uint32_t hotPercent) {
+    mt19937 random(7);
+    vector<uint32_t> hot;
+    for (uint32_t state = 0; state < numStates; state++) {
+        if (random() % 100 < hotPercent) {
+            hot.push_back(state);
+        }
+    }
+    MealyAutomata aut;
+    aut.numStates = numStates;
+    aut.numInputs = numInputs;
+    GenerateSymbols(aut.states, "s", numStates);
+    GenerateSymbols(aut.inputs, "x", numInputs);
+    GenerateSymbols(aut.outputSymbols, "y", 16);
+    aut.next.resize(size_t(numStates) * numInputs);
+    aut.outputs.resize(aut.next.size());
+    for (size_t cell = 0; cell < aut.next.size(); cell++) {
+        aut.next[cell] = random() % 10 != 0 ? hot[random() % hot.size()] : random() % numStates;
+        aut.outputs[cell] = random() % 16;
+    }
+    return aut;
+}
+
+static vector<uint32_t> RandomSymbols(size_t count, uint32_t numInputs, unsigned seed) {
+    mt19937 random(seed);
+    vector<uint32_t> symbols(count);
+    for (uint32_t& symbol : symbols) {
+        symbol = random() % numInputs;
+    }
+    return symbols;
+}
+
+template <class Run>
+static double Seconds(Run&& run) {
+    auto start = chrono::steady_clock::now();
+    run();
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+int main(int argc, char* argv[])
+{
+    uint32_t numInputs = argc > 1 ? strtoul(argv[1], nullptr, 10) : 8;
+    size_t totalSymbols = argc > 2 ? strtoull(argv[2], nullptr, 10) : 1 << 24;
+    uint32_t hotPercent = argc > 3 ? strtoul(argv[3], nullptr, 10) : 2;
+
+    vector<uint32_t> trace = RandomSymbols(totalSymbols / 4, numInputs, 5);
+    vector<uint32_t> symbols = RandomSymbols(totalSymbols, numInputs, 11);
+    vector<uint32_t> outputs(totalSymbols);
+    vector<StreamSpan> streams;
+    for (size_t begin = 0; begin < totalSymbols; begin += 256) {
+        StreamSpan span;
+        span.begin = begin;
+        span.length = min<size_t>(256, totalSymbols - begin);
+        streams.push_back(span);
+    }
+
+    const char* orderNames[] = { "original", "bfs", "frequency" };
+    for (uint32_t numStates : { 60000u, 1048576u }) {
+        MealyAutomata source = HotCoreMealy(numStates, numInputs, hotPercent);
+        cout << "states " << numStates << ", hot " << hotPercent << "%" << endl;
+        for (StateOrder order : { StateOrder::Original, StateOrder::Bfs, StateOrder::Frequency }) {
+            MealyAutomata aut = source;
+            double orderTime = Seconds([&]() {
+                RenumberStatesMealy(aut, StateOrderMealy(aut, order, trace));
+            });
+            MealyAutomata minimized = aut;
+            double minimizeTime = Seconds([&]() {
+                MinimizeMealy(minimized);
+            });
+            for (bool narrow : { false, true }) {
+                Machine machine = MachineFromMealy(aut, narrow);
+                if (narrow && machine.narrowSteps.empty()) {
+                    continue;
+                }
+                double single = Seconds([&]() {
+                    uint32_t state = 0;
+                    RunStream(machine, symbols.data(), totalSymbols, outputs.data(), state);
+                });
+                double interleaved = Seconds([&]() {
+                    RunStreams(machine, symbols.data(), outputs.data(), streams);
+                });
+                cout << "  " << orderNames[static_cast<int>(order)] << (machine.narrowSteps.empty() ? " wide " : " narrow ")
+                    << MachineTableBytes(machine) / 1024 << " KiB: single stream " << totalSymbols / single / 1e6
+                    << " M symbols/s, interleaved x" << MACHINE_LANES << " " << totalSymbols / interleaved / 1e6
+                    << " M symbols/s; renumber " << orderTime * 1000 << " ms, minimize " << minimizeTime * 1000 << " ms" << endl;
+            }
+        }
+    }
+    return 0;
+}
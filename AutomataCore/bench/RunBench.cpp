@@ -0,0 +1,101 @@
+﻿#include "AutomataCore.h"
+#include "Execution.h"
+#include "StreamKernel.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+// Пропускная способность исполнения на случайных полных автоматах Мили разного размера:
+// один длинный поток, независимые потоки по одному, они же вперемешку (RunStreams)
+// и пакетом в ногу (SimulateStreams) с выходами на каждом символе и только с итогом потока.
+// Аргументы: [inputs] [symbols] [stream_length]
+static Machine RandomMachine(uint32_t numStates, uint32_t numInputs, uint32_t numOutputs) {
+    mt19937 random(7);
+    MealyAutomata aut;
+    aut.numStates = numStates;
+    aut.numInputs = numInputs;
+    GenerateSymbols(aut.states, "s", numStates);
+    GenerateSymbols(aut.inputs, "x", numInputs);
+    GenerateSymbols(aut.outputSymbols, "y", numOutputs);
+    aut.next.resize(size_t(numStates) * numInputs);
+    aut.outputs.resize(aut.next.size());
+    for (size_t cell = 0; cell < aut.next.size(); cell++) {
+        aut.next[cell] = random() % numStates;
+        aut.outputs[cell] = random() % numOutputs;
+    }
+    return MachineFromMealy(aut);
+}
+
+template <class Run>
+static double SymbolsPerSecond(size_t symbols, Run&& run) {
+    auto start = chrono::steady_clock::now();
+    run();
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    return symbols / elapsed.count();
+}
+
+int main(int argc, char* argv[])
+{
+    uint32_t numInputs = argc > 1 ? strtoul(argv[1], nullptr, 10) : 8;
+    size_t totalSymbols = argc > 2 ? strtoull(argv[2], nullptr, 10) : 1 << 24;
+    size_t streamLength = argc > 3 ? strtoull(argv[3], nullptr, 10) : 256;
+
+    mt19937 random(11);
+    vector<uint32_t> symbols(totalSymbols);
+    for (uint32_t& symbol : symbols) {
+        symbol = random() % numInputs;
+    }
+    vector<uint32_t> outputs(totalSymbols);
+    vector<StreamSpan> streams;
+    for (size_t begin = 0; begin < totalSymbols; begin += streamLength) {
+        StreamSpan span;
+        span.begin = begin;
+        span.length = min(streamLength, totalSymbols - begin);
+        streams.push_back(span);
+    }
+
+    for (uint32_t numStates : { 256u, 4096u, 16384u, 262144u, 1048576u }) {
+        Machine machine = RandomMachine(numStates, numInputs, 16);
+        double single = SymbolsPerSecond(totalSymbols, [&]() {
+            uint32_t state = 0;
+            RunStream(machine, symbols.data(), totalSymbols, outputs.data(), state);
+        });
+        double sequential = SymbolsPerSecond(totalSymbols, [&]() {
+            for (const StreamSpan& span : streams) {
+                uint32_t state = 0;
+                RunStream(machine, symbols.data() + span.begin, span.length, outputs.data() + span.begin, state);
+            }
+        });
+        double interleaved = SymbolsPerSecond(totalSymbols, [&]() {
+            RunStreams(machine, symbols.data(), outputs.data(), streams);
+        });
+        vector<StreamSpan> expected = streams;
+        vector<uint32_t> batchOutputs(totalSymbols);
+        size_t tableBytes = MachineTableBytes(machine);
+        cout << "states " << numStates << " (table " << tableBytes / 1024 << " KiB): single stream "
+            << single / 1e6 << " M symbols/s, " << streams.size() << " streams one by one " << sequential / 1e6
+            << " M symbols/s, interleaved x" << MACHINE_LANES << " " << interleaved / 1e6 << " M symbols/s" << endl;
+        for (StreamKernel kernel : { StreamKernel::Scalar, DefaultStreamKernel() }) {
+            double batched = SymbolsPerSecond(totalSymbols, [&]() {
+                SimulateStreams(machine, symbols.data(), batchOutputs.data(), streams, kernel);
+            });
+            bool same = batchOutputs == outputs;
+            double finalOnly = SymbolsPerSecond(totalSymbols, [&]() {
+                SimulateStreams(machine, symbols.data(), nullptr, streams, kernel);
+            });
+            for (size_t i = 0; i < streams.size(); i++) {
+                same = same && streams[i].done == expected[i].done && streams[i].state == expected[i].state
+                    && streams[i].output == expected[i].output;
+            }
+            cout << "  lockstep x" << STREAM_BATCH_LANES << (kernel == StreamKernel::Avx2 ? " avx2" : " scalar")
+                << ": outputs " << batched / 1e6 << " M symbols/s, final output only " << finalOnly / 1e6
+                << " M symbols/s" << (same ? "" : ", MISMATCH") << endl;
+        }
+    }
+    return 0;
+}
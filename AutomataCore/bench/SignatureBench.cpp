@@ -0,0 +1,80 @@
+﻿#include "AutomataCore.h"
+#include "SignatureKernel.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+// Сравнение скалярного и AVX2 ядра хеширования сигнатур на случайном автомате.
+// Аргументы: [states] [inputs] [classes] [rounds]
+static double MeasureHash(const vector<uint32_t>& next, uint32_t numInputs, const vector<uint32_t>& classTable,
+    vector<uint64_t>& hashes, SignatureKernel kernel, unsigned rounds)
+{
+    uint32_t numStates = static_cast<uint32_t>(classTable.size());
+    auto start = chrono::steady_clock::now();
+    for (unsigned round = 0; round < rounds; round++) {
+        HashSignatures(next.data(), numInputs, classTable.data(), 0, numStates, hashes.data(), kernel);
+    }
+    chrono::duration<double, nano> elapsed = chrono::steady_clock::now() - start;
+    return elapsed.count() / (double(numStates) * rounds);
+}
+
+static double MeasureCompare(const vector<uint32_t>& next, uint32_t numInputs, const vector<uint32_t>& classTable,
+    SignatureKernel kernel, unsigned rounds, size_t& equalCount)
+{
+    uint32_t numStates = static_cast<uint32_t>(classTable.size());
+    equalCount = 0;
+    auto start = chrono::steady_clock::now();
+    for (unsigned round = 0; round < rounds; round++) {
+        for (uint32_t state = 1; state < numStates; state++) {
+            equalCount += SameSignature(next.data(), numInputs, classTable.data(), state - 1, state, kernel);
+        }
+    }
+    chrono::duration<double, nano> elapsed = chrono::steady_clock::now() - start;
+    return elapsed.count() / (double(numStates) * rounds);
+}
+
+int main(int argc, char* argv[])
+{
+    uint32_t numStates = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1000000;
+    uint32_t numInputs = argc > 2 ? strtoul(argv[2], nullptr, 10) : 64;
+    uint32_t numClasses = argc > 3 ? strtoul(argv[3], nullptr, 10) : 2;
+    unsigned rounds = argc > 4 ? strtoul(argv[4], nullptr, 10) : 5;
+
+    mt19937 random(42);
+    vector<uint32_t> next(size_t(numStates) * numInputs);
+    for (uint32_t& state : next) {
+        // около 5% пустых переходов
+        state = random() % 20 == 0 ? NO_STATE : random() % numStates;
+    }
+    vector<uint32_t> classTable(numStates);
+    for (uint32_t& stateClass : classTable) {
+        stateClass = random() % numClasses;
+    }
+
+    vector<uint64_t> scalarHashes(numStates), vectorHashes(numStates);
+    SignatureKernel vectorKernel = DefaultSignatureKernel();
+    cout << "states " << numStates << ", inputs " << numInputs << ", classes " << numClasses
+        << ", kernel " << (vectorKernel == SignatureKernel::Avx2 ? "avx2" : "scalar (no avx2)") << endl;
+
+    double scalarHash = MeasureHash(next, numInputs, classTable, scalarHashes, SignatureKernel::Scalar, rounds);
+    double vectorHash = MeasureHash(next, numInputs, classTable, vectorHashes, vectorKernel, rounds);
+    if (scalarHashes != vectorHashes) {
+        cerr << "Error: kernels produced different hashes" << endl;
+        return 1;
+    }
+    size_t scalarEqual, vectorEqual;
+    double scalarCompare = MeasureCompare(next, numInputs, classTable, SignatureKernel::Scalar, rounds, scalarEqual);
+    double vectorCompare = MeasureCompare(next, numInputs, classTable, vectorKernel, rounds, vectorEqual);
+    if (scalarEqual != vectorEqual) {
+        cerr << "Error: kernels disagree on signature equality" << endl;
+        return 1;
+    }
+    cout << "hash:    scalar " << scalarHash << " ns/state, vector " << vectorHash << " ns/state, x" << scalarHash / vectorHash << endl;
+    cout << "compare: scalar " << scalarCompare << " ns/state, vector " << vectorCompare << " ns/state, x" << scalarCompare / vectorCompare << endl;
+    return 0;
+}
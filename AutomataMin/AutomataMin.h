@@ -1,12 +1,14 @@
 ﻿#pragma once
 
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
 #include <string>
-#include <vector>
-#include <fstream>
-#include <sstream>
-#include <unordered_map>
-#include <unordered_set>
-#include <set>
-#include <map>
-#include <queue>
\ No newline at end of file
+
+#include "AutomataCore.h"
+#include "Batch.h"
+#include "Execution.h"
+#include "OutputBuffer.h"
+#include "Parallel.h"
+#include "PipelineStats.h"
@@ -0,0 +1,55 @@
+﻿#include "DetermNKA.h"
+
+using namespace std;
+
+const string STATS_FLAG = "--stats";
+const string ARENA_STATS_FLAG = "--arena-stats";
+const string THREADS_FLAG = "--threads";
+
+// Детерминизация таблицы НКА из RegGr; результат - автомат Мура для AutomataMin (CSV или *.bin)
+int main(int argc, char* argv[])
+{
+    if (argc < 3) {
+        cerr << "Usage: " << "<nfa_file> <output_file> [" << THREADS_FLAG << " N] [" << STATS_FLAG << "] [" << ARENA_STATS_FLAG << "]" << endl;
+        return 1;
+    }
+    string inputFile = argv[1];
+    string outputFile = argv[2];
+    bool printStats = false;
+    bool printArenaStats = false;
+    unsigned threads = 1;
+    for (int arg = 3; arg < argc; arg++) {
+        string flag = argv[arg];
+        if (flag == STATS_FLAG) {
+            printStats = true;
+        }
+        else if (flag == ARENA_STATS_FLAG) {
+            printArenaStats = true;
+        }
+        else if (flag == THREADS_FLAG && arg + 1 < argc) {
+            threads = ResolveThreadCount(strtoul(argv[++arg], nullptr, 10));
+        }
+        else {
+            cerr << "Unknown option " << flag << endl;
+            return 1;
+        }
+    }
+    Arena arena;
+    ArenaScope arenaScope(arena);
+    PipelineStats stats(printStats);
+    Nfa nfa = ReadNfa(inputFile);
+    if (nfa.numStates == 0) {
+        return 1;
+    }
+    stats.Mark("read");
+    MooreAutomata dfa = DeterminizeNfa(nfa, threads);
+    stats.Mark("determinize");
+    if (!SaveMoore(dfa, outputFile)) {
+        return 1;
+    }
+    stats.Mark("write");
+    if (printArenaStats) {
+        PrintArenaStats(arena);
+    }
+    return 0;
+}
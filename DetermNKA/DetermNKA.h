@@ -0,0 +1,10 @@
+﻿#pragma once
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "AutomataCore.h"
+#include "Nfa.h"
+#include "Parallel.h"
+#include "PipelineStats.h"
@@ -0,0 +1,116 @@
+﻿import os
+import random
+import subprocess
+import sys
+import tempfile
+import time
+
+# Сравнение DetermNKA с DetermNKAPy на случайных НКА в формате RegGr:
+# время обоих и проверка, что полученные автоматы распознают один язык.
+# При threads > 1 - ещё и параллельный режим, его таблица должна совпасть с однопоточной.
+# Запуск: python determ_bench.py <DetermNKA> [words] [inputs] [seed] [threads]
+
+PYTHON_SCRIPT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "..", "DetermNKAPy", "DetermNKAPy.py")
+EPSILON = "ε"
+
+
+def generate_nfa_csv(num_words, num_inputs, seed):
+    # Словарь как у грамматик лексем: цепочка состояний на слово, из начального состояния
+    # по первой букве во все слова сразу, из конца слова - ε обратно, язык (w1|w2|...)+
+    rnd = random.Random(seed)
+    symbols = [chr(ord('a') + i) for i in range(num_inputs)]
+    cells = [{}]
+    finals = [False]
+    for _ in range(num_words):
+        word = [rnd.choice(symbols) for _ in range(rnd.randint(3, 10))]
+        previous = 0
+        for symbol in word:
+            cells.append({})
+            finals.append(False)
+            cells[previous].setdefault(symbol, []).append(len(cells) - 1)
+            previous = len(cells) - 1
+        finals[previous] = True
+        cells[previous][EPSILON] = [0]
+    rows = [[''] + ['F' if final else '' for final in finals],
+            [''] + [f"q{i}" for i in range(len(cells))]]
+    for symbol in symbols + [EPSILON]:
+        rows.append([symbol] + [','.join(f"q{t}" for t in cell.get(symbol, [])) for cell in cells])
+    return '\n'.join(';'.join(row) for row in rows) + '\n'
+
+
+def read_moore(path):
+    lines = [line.rstrip('\r\n') for line in open(path, encoding='utf-8') if line.strip()]
+    outputs = lines[0].split(';')[1:]
+    states = lines[1].split(';')[1:]
+    transitions = {state: {} for state in states}
+    for line in lines[2:]:
+        cells = line.split(';')
+        for i, state in enumerate(states):
+            target = cells[i + 1] if i + 1 < len(cells) else ''
+            if target:
+                transitions[state][cells[0]] = target
+    return states[0], dict(zip(states, outputs)), transitions
+
+
+def same_language(first, second):
+    # обход пар состояний; отсутствующий переход ведёт в тупик с пустым выходом
+    start_a, out_a, trans_a = first
+    start_b, out_b, trans_b = second
+    symbols = {s for t in trans_a.values() for s in t} | {s for t in trans_b.values() for s in t}
+    seen = {(start_a, start_b)}
+    queue = [(start_a, start_b)]
+    while queue:
+        a, b = queue.pop()
+        if out_a.get(a, '') != out_b.get(b, ''):
+            return False
+        for symbol in symbols:
+            pair = (trans_a.get(a, {}).get(symbol), trans_b.get(b, {}).get(symbol))
+            if pair not in seen:
+                seen.add(pair)
+                queue.append(pair)
+    return True
+
+
+def timed(command):
+    start = time.perf_counter()
+    subprocess.run(command, check=True, stdout=subprocess.DEVNULL)
+    return time.perf_counter() - start
+
+
+def main():
+    if len(sys.argv) < 2:
+        print("Usage: determ_bench.py <DetermNKA> [words] [inputs] [seed] [threads]")
+        sys.exit(1)
+    binary = sys.argv[1]
+    num_words = int(sys.argv[2]) if len(sys.argv) > 2 else 200
+    num_inputs = int(sys.argv[3]) if len(sys.argv) > 3 else 3
+    seed = int(sys.argv[4]) if len(sys.argv) > 4 else 1
+    threads = int(sys.argv[5]) if len(sys.argv) > 5 else 1
+
+    with tempfile.TemporaryDirectory() as work:
+        nfa_file = os.path.join(work, "nfa.csv")
+        with open(nfa_file, 'w', encoding='utf-8') as file:
+            file.write(generate_nfa_csv(num_words, num_inputs, seed))
+        py_file = os.path.join(work, "py.csv")
+        cpp_file = os.path.join(work, "cpp.csv")
+        py_time = timed([sys.executable, PYTHON_SCRIPT, nfa_file, py_file])
+        cpp_time = timed([binary, nfa_file, cpp_file])
+        py_dfa = read_moore(py_file)
+        cpp_dfa = read_moore(cpp_file)
+        print(f"NFA of {num_words} words, {num_inputs} inputs: "
+              f"DetermNKAPy {py_time:.3f} s ({len(py_dfa[1])} states), "
+              f"DetermNKA {cpp_time:.3f} s ({len(cpp_dfa[1])} states), x{py_time / cpp_time:.0f}")
+        if not same_language(py_dfa, cpp_dfa):
+            print("MISMATCH: automata accept different languages")
+            sys.exit(1)
+        if threads > 1:
+            parallel_file = os.path.join(work, "parallel.csv")
+            parallel_time = timed([binary, nfa_file, parallel_file, "--threads", str(threads)])
+            print(f"DetermNKA --threads {threads} {parallel_time:.3f} s, x{cpp_time / parallel_time:.2f}")
+            if open(parallel_file, 'rb').read() != open(cpp_file, 'rb').read():
+                print("MISMATCH: parallel table differs from single-threaded")
+                sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
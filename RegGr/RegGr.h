@@ -1,15 +1,11 @@
 ﻿#pragma once
 
+#include <cstdlib>
+#include <exception>
 #include <iostream>
-#include <vector>
-#include <map>
-#include <set>
 #include <string>
-#include <regex>
-#include <sstream>
-#include <fstream>
-#include <locale>
-#include <numeric>
-#include <algorithm>
-#include <codecvt>
-#include <stdexcept>
\ No newline at end of file
+
+#include "AutomataCore.h"
+#include "Grammar.h"
+#include "Parallel.h"
+#include "PipelineStats.h"
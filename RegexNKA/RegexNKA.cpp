@@ -0,0 +1,75 @@
+﻿#include "RegexNKA.h"
+
+using namespace std;
+
+const string DFA_FLAG = "--dfa";
+const string MINIMIZE_FLAG = "--minimize";
+const string THREADS_FLAG = "--threads";
+const string STATS_FLAG = "--stats";
+
+// Аргументы как у lw5.py; без флагов - таблица НКА для DetermNKA (автомат Глушкова, без ε).
+// --dfa - детерминизация в том же процессе, результат - автомат Мура для AutomataMin (CSV или *.bin);
+// --minimize подразумевает --dfa
+int main(int argc, char* argv[])
+{
+    if (argc < 3) {
+        cerr << "Usage: " << "<output_file> \"<regex>\" [" << DFA_FLAG << "] [" << MINIMIZE_FLAG << "] ["
+            << THREADS_FLAG << " N] [" << STATS_FLAG << "]" << endl;
+        return 1;
+    }
+    string outputFile = argv[1];
+    string pattern = argv[2];
+    bool toDfa = false;
+    bool minimize = false;
+    unsigned threads = 1;
+    bool printStats = false;
+    for (int arg = 3; arg < argc; arg++) {
+        string flag = argv[arg];
+        if (flag == DFA_FLAG) {
+            toDfa = true;
+        }
+        else if (flag == MINIMIZE_FLAG) {
+            toDfa = true;
+            minimize = true;
+        }
+        else if (flag == THREADS_FLAG && arg + 1 < argc) {
+            threads = ResolveThreadCount(strtoul(argv[++arg], nullptr, 10));
+        }
+        else if (flag == STATS_FLAG) {
+            printStats = true;
+        }
+        else {
+            cerr << "Unknown option " << flag << endl;
+            return 1;
+        }
+    }
+    Arena arena;
+    ArenaScope arenaScope(arena);
+    PipelineStats stats(printStats);
+    try {
+        Nfa nfa = RegexToNfa(pattern);
+        stats.Mark("compile");
+        if (!toDfa) {
+            if (!SaveNfa(nfa, outputFile)) {
+                return 1;
+            }
+            stats.Mark("write");
+            return 0;
+        }
+        MooreAutomata dfa = DeterminizeNfa(nfa, threads);
+        stats.Mark("determinize");
+        if (minimize) {
+            MinimizeMoore(dfa, threads > 1 ? MinimizationEngine::Parallel : MinimizationEngine::Hopcroft, threads);
+            stats.Mark("minimize");
+        }
+        if (!SaveMoore(dfa, outputFile)) {
+            return 1;
+        }
+        stats.Mark("write");
+    }
+    catch (const exception& error) {
+        cerr << "Error: " << error.what() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,12 @@
+﻿#pragma once
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+#include "AutomataCore.h"
+#include "Nfa.h"
+#include "Parallel.h"
+#include "PipelineStats.h"
+#include "Regex.h"
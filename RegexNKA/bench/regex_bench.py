@@ -0,0 +1,114 @@
+﻿import os
+import random
+import sys
+import tempfile
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "..", "DetermNKA", "bench"))
+from determ_bench import read_moore, timed
+
+# Сравнение RegexNKA с lw5.py на наборе правил лексера: время построения НКА обоими,
+# время RegexNKA до минимального ДКА и проверка, что НКА lw5 и этот ДКА распознают один язык.
+# Запуск: python regex_bench.py <RegexNKA> [words] [seed]
+
+LW5_SCRIPT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "..", "lw5", "lw5.py")
+EPSILON = "ε"
+GROUP_SIZE = 20
+
+
+def generate_regex(num_words, seed):
+    # Ключевые слова из своих букв, чтобы не сливались с идентификаторами, идентификаторы и числа;
+    # всё выражение повторяется через пробел. Слова идут группами: lw5 разбирает выбор рекурсией,
+    # и длинный плоский выбор упирается в её предел
+    rnd = random.Random(seed)
+    keyword_letters = "fghijk"
+    letters = "abcde"
+    words = ["".join(rnd.choice(keyword_letters) for _ in range(rnd.randint(2, 8))) for _ in range(num_words)]
+    groups = ["(" + "|".join(words[i:i + GROUP_SIZE]) + ")" for i in range(0, len(words), GROUP_SIZE)]
+    identifier = "(" + "|".join(letters) + ")(" + "|".join(letters + "0123") + ")*"
+    number = "(0|1|2|3)+"
+    token = "(" + "|".join(groups + [identifier, number]) + ")"
+    return token + "( " + token + ")*"
+
+
+def read_nfa(path):
+    lines = [line.rstrip('\r\n') for line in open(path, encoding='utf-8') if line.strip()]
+    outputs = lines[0].split(';')[1:]
+    states = lines[1].split(';')[1:]
+    transitions = {state: {} for state in states}
+    for line in lines[2:]:
+        cells = line.split(';')
+        for i, state in enumerate(states):
+            cell = cells[i + 1] if i + 1 < len(cells) else ''
+            targets = [target for target in cell.split(',') if target]
+            if targets:
+                transitions[state].setdefault(cells[0], []).extend(targets)
+    return states[0], dict(zip(states, outputs)), transitions
+
+
+def same_language_nfa_dfa(nfa, dfa):
+    # подмножества НКА строятся по ходу обхода пар (подмножество, состояние ДКА)
+    nfa_start, nfa_out, nfa_trans = nfa
+    dfa_start, dfa_out, dfa_trans = dfa
+    closures = {}
+
+    def closure(state):
+        if state not in closures:
+            seen = {state}
+            stack = [state]
+            while stack:
+                for target in nfa_trans[stack.pop()].get(EPSILON, []):
+                    if target not in seen:
+                        seen.add(target)
+                        stack.append(target)
+            closures[state] = frozenset(seen)
+        return closures[state]
+
+    symbols = ({s for t in nfa_trans.values() for s in t} | {s for t in dfa_trans.values() for s in t}) - {EPSILON}
+    start = (closure(nfa_start), dfa_start)
+    seen = {start}
+    queue = [start]
+    while queue:
+        subset, state = queue.pop()
+        nfa_final = any(nfa_out[member] == 'F' for member in subset)
+        dfa_final = state is not None and dfa_out[state] == 'F'
+        if nfa_final != dfa_final:
+            return False
+        for symbol in symbols:
+            targets = frozenset().union(*(closure(t) for member in subset for t in nfa_trans[member].get(symbol, [])))
+            pair = (targets, dfa_trans.get(state, {}).get(symbol) if state is not None else None)
+            if pair not in seen:
+                seen.add(pair)
+                queue.append(pair)
+    return True
+
+
+def main():
+    if len(sys.argv) < 2:
+        print("Usage: regex_bench.py <RegexNKA> [words] [seed]")
+        sys.exit(1)
+    binary = sys.argv[1]
+    num_words = int(sys.argv[2]) if len(sys.argv) > 2 else 1000
+    seed = int(sys.argv[3]) if len(sys.argv) > 3 else 1
+    regex = generate_regex(num_words, seed)
+
+    with tempfile.TemporaryDirectory() as work:
+        lw5_file = os.path.join(work, "lw5.csv")
+        nfa_file = os.path.join(work, "nfa.csv")
+        dfa_file = os.path.join(work, "dfa.csv")
+        lw5_time = timed([sys.executable, LW5_SCRIPT, lw5_file, regex])
+        nfa_time = timed([binary, nfa_file, regex])
+        dfa_time = timed([binary, dfa_file, regex, "--minimize"])
+        lw5_nfa = read_nfa(lw5_file)
+        glushkov = read_nfa(nfa_file)
+        dfa = read_moore(dfa_file)
+        print(f"regex of {len(regex)} characters ({num_words} words): "
+              f"lw5.py {lw5_time:.3f} s ({len(lw5_nfa[1])} NFA states), "
+              f"RegexNKA {nfa_time:.3f} s ({len(glushkov[1])} NFA states), x{lw5_time / nfa_time:.0f}; "
+              f"RegexNKA --minimize {dfa_time:.3f} s ({len(dfa[1])} DFA states)")
+        if not same_language_nfa_dfa(lw5_nfa, dfa):
+            print("MISMATCH: lw5.py NFA and minimized DFA accept different languages")
+            sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()